@@ -4,6 +4,8 @@
 #include <xrplorer/context.hpp>
 #include <xrplorer/export.hpp>
 
+#include <xrpl/json/json_value.h>
+
 #include <cassert>
 #include <string>
 #include <vector>
@@ -16,6 +18,9 @@ template <typename Derived, typename T = void>
 struct Entry {
     static void call(Context& ctx, T* spl = nullptr) {
         ctx.skipEmpty();
+        if (ctx.it != ctx.path.end() && ctx.atGlob()) {
+            return Derived::_expand(ctx, spl);
+        }
         if (ctx.it != ctx.path.end()) {
             auto const& name = *ctx.it++;
             return Derived::_open(ctx, spl, name);
@@ -27,10 +32,24 @@ struct Entry {
             return ctx.list(Derived::_list(ctx, spl));
         }
         if (ctx.action == CAT) {
+            if (ctx.wantsJson()) {
+                return ctx.print(Derived::_json(ctx, spl));
+            }
             return ctx.echo(Derived::_stream(ctx, spl));
         }
+        if (ctx.action == RESOLVE) {
+            return Derived::_resolve(ctx, spl);
+        }
         assert(UNREACHABLE);
     }
+    // Follow every name that matches the glob at `ctx.it`.
+    static void _expand(Context& ctx, T* spl) {
+        return ctx.expand(
+            [&]() { return Derived::_list(ctx, spl); },
+            [&](Context& branch, fs::path const& name) {
+                return Derived::_open(branch, spl, name);
+            });
+    }
     static void _open(Context& ctx, T* spl, fs::path const& name) {
         return Derived::open(ctx, name);
     }
@@ -40,6 +59,12 @@ struct Entry {
     static std::string _stream(Context& ctx, T* spl) {
         return Derived::stream(ctx);
     }
+    static Json::Value _json(Context& ctx, T* spl) {
+        return Derived::json(ctx);
+    }
+    static void _resolve(Context& ctx, T* spl) {
+        return Derived::resolve(ctx);
+    }
 };
 
 template <typename Derived, typename T = void>
@@ -57,6 +82,11 @@ struct Directory : public Entry<Derived, T> {
     static std::string stream(Context& ctx) {
         throw ctx.notFile();
     }
+    static Json::Value json(Context& ctx) {
+        return Derived::stream(ctx);
+    }
+    static void resolve(Context& ctx) {
+    }
 };
 
 template <typename Derived, typename T = void>
@@ -73,6 +103,11 @@ struct File : public Entry<Derived, T> {
     static std::string stream(Context& ctx) {
         throw ctx.notImplemented();
     }
+    static Json::Value json(Context& ctx) {
+        return Derived::stream(ctx);
+    }
+    static void resolve(Context& ctx) {
+    }
 };
 
 template <template <typename, typename> typename Base, typename Derived, typename T>
@@ -81,6 +116,8 @@ struct Special : public Base<Derived, T> {
     using Base<Derived, T>::open;
     using Base<Derived, T>::list;
     using Base<Derived, T>::stream;
+    using Base<Derived, T>::json;
+    using Base<Derived, T>::resolve;
     using value_type = T;
     static void call(Context& ctx, T& spl) {
         return Base<Derived, T>::call(ctx, &spl);
@@ -103,6 +140,18 @@ struct Special : public Base<Derived, T> {
     static std::string stream(Context& ctx, T& spl) {
         return Derived::stream(ctx);
     }
+    static Json::Value _json(Context& ctx, T* spl) {
+        return Derived::json(ctx, *static_cast<T*>(spl));
+    }
+    static Json::Value json(Context& ctx, T& spl) {
+        return Derived::stream(ctx, spl);
+    }
+    static void _resolve(Context& ctx, T* spl) {
+        return Derived::resolve(ctx, *static_cast<T*>(spl));
+    }
+    static void resolve(Context& ctx, T& spl) {
+        return Derived::resolve(ctx);
+    }
 };
 
 template <typename Derived, typename T>
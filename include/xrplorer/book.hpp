@@ -0,0 +1,49 @@
+#ifndef XRPLORER_BOOK_HPP
+#define XRPLORER_BOOK_HPP
+
+#include <xrplorer/context.hpp>
+#include <xrplorer/database.hpp>
+#include <xrplorer/export.hpp>
+#include <xrplorer/shims.hpp>
+
+#include <xrpl/protocol/Book.h>
+#include <xrpl/protocol/Issue.h>
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace xrplorer {
+
+/** Parse an issue written `XRP` or `<currency>.<issuer address>`. */
+XRPLORER_EXPORT std::optional<ripple::Issue> parseIssue(std::string_view name);
+
+/** The inverse of `parseIssue`. */
+XRPLORER_EXPORT std::string formatIssue(ripple::Issue const& issue);
+
+/** Return `false` to stop the visit. */
+using OfferVisitor = std::function<bool(ripple::SLE const& offer)>;
+
+/**
+ * Visit the offers in `book` under the state tree `root`
+ * in the order that they would be taken:
+ * best quality first, then by page and position in each quality directory.
+ * The next directory page and up to `lookahead` offers
+ * (by default, `Database::concurrency()`)
+ * are fetched by the read threads of the node store while the visitor runs,
+ * sharing the inner nodes near the root.
+ * Returns `false` if the visitor stopped the visit.
+ * Throws `Exception` with `NODE_MISSING`
+ * for a missing node, page or offer.
+ */
+XRPLORER_EXPORT bool visitBook(
+    Database& db,
+    NodePtr const& root,
+    ripple::Book const& book,
+    OfferVisitor const& visitor,
+    std::optional<unsigned int> lookahead = std::nullopt);
+
+}
+
+#endif
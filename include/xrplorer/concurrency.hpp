@@ -0,0 +1,50 @@
+#ifndef XRPLORER_CONCURRENCY_HPP
+#define XRPLORER_CONCURRENCY_HPP
+
+#include <xrplorer/export.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+namespace xrplorer {
+
+/**
+ * A limit on the number of concurrent fetches.
+ *
+ * A fixed limit never changes.
+ * An adaptive limit follows the gradient between the best observed
+ * fetch latency and the recent average:
+ * when latency rises above its floor, requests are queueing in the
+ * storage device, and the limit shrinks;
+ * when latency stays near its floor, the limit grows by a small
+ * queue allowance until it reaches the maximum.
+ */
+class XRPLORER_EXPORT ConcurrencyLimit {
+private:
+    // Number of samples between adjustments.
+    static constexpr std::uint64_t WINDOW = 256;
+
+    unsigned int max_;
+    bool adaptive_;
+    std::atomic<unsigned int> limit_;
+    std::atomic<std::uint64_t> samples_{0};
+    std::atomic<std::uint64_t> nanos_{0};
+    // Guards the adjustment.
+    std::mutex mutex_;
+    double floor_ = 0;
+
+public:
+    ConcurrencyLimit(unsigned int max, bool adaptive);
+
+    unsigned int get() const {
+        return limit_.load(std::memory_order_relaxed);
+    }
+
+    void sample(std::chrono::nanoseconds latency);
+};
+
+}
+
+#endif
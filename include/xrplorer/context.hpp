@@ -2,11 +2,15 @@
 #define XRPLORER_CONTEXT_HPP
 
 #include <xrplorer/export.hpp>
+#include <xrplorer/object.hpp>
 #include <xrplorer/operating-system.hpp>
 
+#include <xrpl/json/json_value.h>
 #include <xrpl/nodestore/NodeObject.h>
 
+#include <cstdio>
 #include <filesystem>
+#include <functional>
 #include <memory>
 #include <string>
 #include <string_view>
@@ -22,6 +26,8 @@ enum XRPLORER_EXPORT Action {
     CD,
     LS,
     CAT,
+    // Find the node at the end of the path, if it has one.
+    RESOLVE,
 };
 
 // TODO: Pair these with their message strings.
@@ -35,6 +41,13 @@ enum XRPLORER_EXPORT ErrorCode {
     // Path is an entry in its parent directory, but contents are missing.
     NODE_MISSING,
     TYPE_UNKNOWN,
+    NOT_A_LEDGER,
+    WRITE_FAILED,
+    // A glob matches more than one entry where only one is allowed.
+    AMBIGUOUS,
+    NOT_A_TRACE,
+    // A snapshot file whose header, index or records are out of bounds.
+    NOT_A_SNAPSHOT,
 };
 
 struct XRPLORER_EXPORT Exception {
@@ -43,6 +56,9 @@ struct XRPLORER_EXPORT Exception {
     std::string message;
 };
 
+/** Stream JSON, followed by a newline, to a (buffered) file. */
+XRPLORER_EXPORT void printJson(FILE* out, Json::Value const& value);
+
 struct XRPLORER_EXPORT Context {
     OperatingSystem& os;
     // The path argument as written.
@@ -51,10 +67,14 @@ struct XRPLORER_EXPORT Context {
     fs::path& path;
     fs::path::iterator it;
     Action action;
+    // Where output goes: `os.stdout`, or a buffer for one branch of a glob.
+    FILE* out;
     // The prefix for tab-completion, if any.
     std::string_view prefix;
     // The nearest SHAMap root, if any.
     NodePtr root;
+    // What RESOLVE found at the end of the path.
+    Resolution found;
 
     Exception throw_(ErrorCode code, std::string_view message);
     Exception notFile();
@@ -62,8 +82,25 @@ struct XRPLORER_EXPORT Context {
     Exception notExists();
     Exception notImplemented();
     void skipEmpty();
+    /** True if the current path component is a glob pattern. */
+    bool atGlob() const;
+    /**
+     * Expand the glob at the current path component
+     * against the names from `list`,
+     * skipping placeholders like `<node ID>`,
+     * and continue down each match with `open`.
+     * Matches are followed in parallel,
+     * but their output is written in the order of the listing.
+     * If any match fails, the first failure is rethrown at the end.
+     */
+    void expand(
+        std::function<std::vector<std::string>()> const& list,
+        std::function<void(Context&, fs::path const&)> const& open);
+    // True when the environment sets `FORMAT=json`.
+    bool wantsJson() const;
     void list(std::vector<std::string> const& names);
     void echo(std::string_view text);
+    void print(Json::Value const& value);
 };
 
 }
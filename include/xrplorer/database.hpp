@@ -1,34 +1,115 @@
 #ifndef XRPLORER_DATABASE_HPP
 #define XRPLORER_DATABASE_HPP
 
+#include <xrplorer/concurrency.hpp>
 #include <xrplorer/export.hpp>
 
+#include <xrpl/basics/ByteUtilities.h> // megabytes()
 #include <xrpl/basics/Log.h>  // Logs
+#include <xrpl/basics/base_uint.h>
 #include <xrpl/beast/insight/NullCollector.h>
 #include <xrpl/beast/utility/Journal.h>
 #include <xrpl/jobqueue/JobQueue.h>
 #include <xrpl/jobqueue/NullPerfLog.h>
 #include <xrpl/nodestore/Database.h>
+#include <xrpl/nodestore/NodeObject.h>
 #include <xrpl/nodestore/NodeStoreScheduler.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <thread>
 
 namespace xrplorer {
 
+struct XRPLORER_EXPORT DatabaseOptions {
+    // Threads in the `JobQueue` that runs the `NodeStore` scheduler.
+    int jobThreads = 4;
+    // Threads in the `NodeStore` that serve asynchronous fetches.
+    int readThreads = 4;
+    std::size_t burstSize = ripple::megabytes(32);
+    // Maximum number of concurrent synchronous fetches in a parallel walk.
+    unsigned int walkers = std::max(std::thread::hardware_concurrency(), 1u);
+    // Scale the walkers with the observed fetch latency.
+    bool adaptive = false;
+    // Node objects kept in memory after they are fetched.
+    // Zero leaves the node store without a cache.
+    int cacheSize = 0;
+    // Minutes that a cached node object outlives its last fetch.
+    int cacheAge = 0;
+};
+
+/** Cumulative fetch counters. */
+struct XRPLORER_EXPORT FetchStats {
+    std::uint64_t fetches = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t bytes = 0;
+    std::uint64_t nanos = 0;
+};
+
+class KeyIndex;
+struct MaterializedState;
+class TraceWriter;
+
 struct XRPLORER_EXPORT Database {
 
+    DatabaseOptions options_;
     std::shared_ptr<beast::insight::Collector> collector_{
         beast::insight::NullCollector::New()};
     beast::Journal journal_{};
     ripple::Logs logs_{beast::severities::kFatal};
     ripple::perf::NullPerfLog perflog_{};
     ripple::JobQueue jobQueue_{
-        /*threadCount=*/4, collector_, journal_, logs_, perflog_};
+        options_.jobThreads, collector_, journal_, logs_, perflog_};
     ripple::NodeStoreScheduler scheduler_{jobQueue_};
     std::unique_ptr<ripple::NodeStore::Database> db_;
+    ConcurrencyLimit limit_{options_.walkers, options_.adaptive};
+    std::atomic<std::uint64_t> fetches_{0};
+    std::atomic<std::uint64_t> misses_{0};
+    std::atomic<std::uint64_t> bytes_{0};
+    std::atomic<std::uint64_t> nanos_{0};
+    // Checked before `trace_`, which costs a lock to load.
+    std::atomic<bool> tracing_{false};
+    std::atomic<std::shared_ptr<TraceWriter>> trace_;
+    // Opened on first use by `openKeyIndex`.
+    std::mutex keyIndexMutex_;
+    std::shared_ptr<KeyIndex> keyIndex_;
+    // Set by `materialize`.
+    std::atomic<std::shared_ptr<MaterializedState const>> materialized_;
+
+    Database(std::filesystem::path path, DatabaseOptions const& options = {});
+
+    /**
+     * Fetch a node object, timing it.
+     * Every read should come through here.
+     */
+    std::shared_ptr<ripple::NodeObject> fetch(ripple::uint256 const& digest);
+
+    /**
+     * Queue a fetch for the read threads of the node store,
+     * which call `callback` when it completes, timed like `fetch`.
+     */
+    void asyncFetch(
+        ripple::uint256 const& digest,
+        std::function<void(std::shared_ptr<ripple::NodeObject> const&)> callback);
+
+    /** The number of fetches that parallel walks should keep in flight. */
+    unsigned int concurrency() const {
+        return limit_.get();
+    }
+
+    FetchStats stats() const;
 
-    Database(std::filesystem::path path);
+    /**
+     * Record every fetch to `trace` until the next call.
+     * Pass null to stop. Returns the previous trace, if any.
+     */
+    std::shared_ptr<TraceWriter> trace(std::shared_ptr<TraceWriter> trace);
 
     operator bool () const {
         return !!db_;
@@ -0,0 +1,79 @@
+#ifndef XRPLORER_DIGEST_SET_HPP
+#define XRPLORER_DIGEST_SET_HPP
+
+#include <xrplorer/export.hpp>
+
+#include <boost/unordered/unordered_flat_set.hpp>
+#include <xrpl/basics/base_uint.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+
+namespace xrplorer {
+
+/**
+ * Digests are already uniformly distributed,
+ * so any 8 of their bytes make a good hash.
+ */
+struct DigestHash {
+    std::size_t operator() (ripple::uint256 const& digest) const {
+        std::uint64_t hash;
+        std::memcpy(&hash, digest.data() + 8, sizeof(hash));
+        return hash;
+    }
+};
+
+/**
+ * A set of node digests that many threads can fill at once.
+ * It is split into shards by the first byte of the digest,
+ * each an open-addressing table behind its own lock.
+ */
+class XRPLORER_EXPORT DigestSet {
+private:
+    static constexpr std::size_t NSHARDS = 256;
+
+    struct alignas(64) Shard {
+        mutable std::mutex mutex;
+        boost::unordered_flat_set<ripple::uint256, DigestHash> digests;
+    };
+
+    std::array<Shard, NSHARDS> shards_;
+
+    Shard& shard(ripple::uint256 const& digest) {
+        return shards_[*digest.data()];
+    }
+
+    Shard const& shard(ripple::uint256 const& digest) const {
+        return shards_[*digest.data()];
+    }
+
+public:
+    /** Return `true` if `digest` was not already in the set. */
+    bool insert(ripple::uint256 const& digest) {
+        auto& shard_ = shard(digest);
+        std::lock_guard lock{shard_.mutex};
+        return shard_.digests.insert(digest).second;
+    }
+
+    bool contains(ripple::uint256 const& digest) const {
+        auto const& shard_ = shard(digest);
+        std::lock_guard lock{shard_.mutex};
+        return shard_.digests.contains(digest);
+    }
+
+    std::size_t size() const {
+        std::size_t size = 0;
+        for (auto const& shard_ : shards_) {
+            std::lock_guard lock{shard_.mutex};
+            size += shard_.digests.size();
+        }
+        return size;
+    }
+};
+
+}
+
+#endif
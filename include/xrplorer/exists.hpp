@@ -0,0 +1,104 @@
+#ifndef XRPLORER_EXISTS_HPP
+#define XRPLORER_EXISTS_HPP
+
+#include <xrplorer/database.hpp>
+#include <xrplorer/export.hpp>
+
+#include <xrpl/basics/base_uint.h>
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace xrplorer {
+
+/**
+ * A Bloom filter over 64-bit hashes.
+ * Insertion is safe from many threads at once.
+ */
+class XRPLORER_EXPORT BloomFilter {
+private:
+    std::vector<std::atomic<std::uint64_t>> words_;
+    std::uint64_t nbits_;
+    unsigned int nhashes_;
+
+public:
+    /** Size the filter for `expected` hashes at `bitsPerKey` bits each. */
+    BloomFilter(std::uint64_t expected, double bitsPerKey = 10);
+
+    void insert(std::uint64_t hash);
+    /** Never `false` for a hash that was inserted. */
+    bool mayContain(std::uint64_t hash) const;
+
+    std::size_t bytes() const {
+        return words_.size() * sizeof(std::uint64_t);
+    }
+};
+
+struct XRPLORER_EXPORT ExistsStats {
+    std::uint64_t queries = 0;
+    std::uint64_t present = 0;
+    // Queries that the Bloom filter answered without reading a bucket.
+    std::uint64_t filtered = 0;
+    // Distinct buckets read, and spill buckets followed from them.
+    std::uint64_t buckets = 0;
+    std::uint64_t spills = 0;
+};
+
+/**
+ * A read-only view of the key file of a NuDB store,
+ * which maps the hash of every key to the offset of its record,
+ * to answer whether the store holds a key without reading its value.
+ *
+ * A key is reported present when its 48-bit hash is in its bucket,
+ * so a false positive has a chance of about 2^-48 per entry in the bucket.
+ * Objects still in the log of a running store are not seen.
+ */
+class XRPLORER_EXPORT KeyIndex {
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+
+public:
+    /**
+     * Map `nudb.key` and `nudb.dat` under `directory`. Throws `Exception`.
+     * `workers` is the default for `buildFilter` and `contains`.
+     */
+    KeyIndex(std::filesystem::path const& directory, unsigned int workers = 1);
+    ~KeyIndex();
+
+    /**
+     * Read every bucket once to fill a Bloom filter,
+     * which then answers most absent keys without touching the key file.
+     */
+    void buildFilter(std::optional<unsigned int> workers = std::nullopt);
+    bool hasFilter() const;
+    std::size_t filterBytes() const;
+
+    /**
+     * For each of `digests`, whether the store holds it.
+     * Queries are sorted by bucket and split among `workers`,
+     * but never more workers than queries,
+     * so that each worker reads its part of the key file in order.
+     */
+    std::vector<bool> contains(
+        std::vector<ripple::uint256> const& digests,
+        ExistsStats& stats,
+        std::optional<unsigned int> workers = std::nullopt) const;
+};
+
+/**
+ * The key index of the store at `directory`,
+ * opened on first use and kept with `db`,
+ * with `DatabaseOptions::walkers` workers.
+ * With `filter`, its Bloom filter is built if it is not already.
+ */
+XRPLORER_EXPORT std::shared_ptr<KeyIndex const> openKeyIndex(
+    Database& db, std::filesystem::path const& directory, bool filter);
+
+}
+
+#endif
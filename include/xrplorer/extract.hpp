@@ -0,0 +1,71 @@
+#ifndef XRPLORER_EXTRACT_HPP
+#define XRPLORER_EXTRACT_HPP
+
+#include <xrplorer/context.hpp>
+#include <xrplorer/database.hpp>
+#include <xrplorer/export.hpp>
+
+#include <xrpl/basics/Slice.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+
+/**
+ * A transaction stream holds every transaction, with its metadata,
+ * of a range of ledgers, oldest ledger first
+ * and in the order of application within each ledger.
+ *
+ * As NDJSON, it is one object per line:
+ *     {"ledger_index", "hash", "tx", "meta"}
+ *
+ * As binary, all integers are little-endian:
+ *     [0, 16)            header
+ *         magic "XRPLTXNS" (8), version (4), reserved (4)
+ *     [16, end)          records
+ *         ledger sequence (4), transaction index (4), transaction ID (32),
+ *         size of transaction (4), transaction,
+ *         size of metadata (4), metadata
+ */
+namespace xrplorer {
+
+enum class StreamFormat { BINARY, NDJSON };
+
+struct XRPLORER_EXPORT ExtractStats {
+    std::uint64_t ledgers = 0;
+    std::uint64_t transactions = 0;
+    // Bytes written.
+    std::uint64_t bytes = 0;
+};
+
+/**
+ * Write the transactions of ledgers `from` to `to`, ancestors of `anchor`,
+ * to `out` in `format`.
+ *
+ * Each of `workers` threads takes the next ledger in the range,
+ * finds its header through the skip lists of ledger `to`,
+ * reads its whole transaction tree and encodes it.
+ * Encoded ledgers wait in a reorder buffer of `window` ledgers
+ * until those before them are written,
+ * so workers never run more than `window` ledgers ahead of the output.
+ * Throws if any node in a transaction tree is missing.
+ */
+XRPLORER_EXPORT ExtractStats extractTransactions(
+    Database& db,
+    NodePtr const& anchor,
+    std::uint32_t from,
+    std::uint32_t to,
+    FILE* out,
+    StreamFormat format,
+    std::optional<unsigned int> workers = std::nullopt,
+    std::optional<unsigned int> window = std::nullopt);
+
+/**
+ * Read `sfTransactionIndex` from serialized metadata without deserializing it.
+ * It has the smallest field code in metadata and is serialized first.
+ */
+XRPLORER_EXPORT std::optional<std::uint32_t> peekTransactionIndex(ripple::Slice const& meta);
+
+}
+
+#endif
@@ -6,6 +6,8 @@
 
 #include <xrpl/basics/base_uint.h>
 
+#include <string_view>
+
 namespace xrplorer {
 
 struct RootDirectory : public Directory<RootDirectory> {
@@ -15,6 +17,14 @@ struct RootDirectory : public Directory<RootDirectory> {
     static void open(Context& ctx, fs::path const& name);
 };
 
+/**
+ * Apply `action` to `argument`,
+ * a path relative to the working directory.
+ * Throws `Exception`.
+ */
+XRPLORER_EXPORT Resolution command(
+    OperatingSystem& os, std::string_view argument, Action action);
+
 }
 
 #endif
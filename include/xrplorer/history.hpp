@@ -0,0 +1,58 @@
+#ifndef XRPLORER_HISTORY_HPP
+#define XRPLORER_HISTORY_HPP
+
+#include <xrplorer/context.hpp>
+#include <xrplorer/database.hpp>
+#include <xrplorer/export.hpp>
+
+#include <xrpl/basics/base_uint.h>
+#include <xrpl/protocol/LedgerHeader.h>
+
+#include <cstdint>
+#include <functional>
+
+namespace xrplorer {
+
+struct XRPLORER_EXPORT EntryChange {
+    // The ledger in which the change appears.
+    ripple::LedgerHeader header;
+    // The leaf in the parent ledger, or null if the entry did not exist.
+    NodePtr before;
+    // The leaf in this ledger, or null if the entry was deleted.
+    NodePtr after;
+};
+
+/** Return `false` to stop the walk. */
+using ChangeVisitor = std::function<bool(EntryChange const&)>;
+
+struct XRPLORER_EXPORT EntryHistory {
+    // The leaf in ledger `from`, or null if the entry did not exist
+    // or the visitor stopped the walk before it got there.
+    NodePtr initial;
+    // Number of ledgers compared with their parent.
+    std::uint64_t ledgers = 0;
+    // Number of those where a shared digest on the path to the key
+    // proved the entry unchanged.
+    std::uint64_t unchanged = 0;
+};
+
+/**
+ * Visit, newest first, every change to the entry at `key`
+ * between ledgers `from` and `to`, ancestors of `anchor`.
+ *
+ * Each ledger's path to `key` is compared with its child's,
+ * which is already in memory,
+ * and fetched only down to the first digest that the two share.
+ * Leaves are fetched only when the paths differ all the way down.
+ */
+XRPLORER_EXPORT EntryHistory entryHistory(
+    Database& db,
+    NodePtr const& anchor,
+    ripple::uint256 const& key,
+    std::uint32_t from,
+    std::uint32_t to,
+    ChangeVisitor const& visitor);
+
+}
+
+#endif
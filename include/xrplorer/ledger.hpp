@@ -0,0 +1,47 @@
+#ifndef XRPLORER_LEDGER_HPP
+#define XRPLORER_LEDGER_HPP
+
+#include <xrplorer/context.hpp>
+#include <xrplorer/database.hpp>
+#include <xrplorer/export.hpp>
+
+#include <xrpl/basics/base_uint.h>
+#include <xrpl/protocol/LedgerHeader.h>
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace xrplorer {
+
+/** Return the leaf for `key` in the state tree of `header`, or null. */
+XRPLORER_EXPORT NodePtr readLeaf(
+    Database& db, ripple::LedgerHeader const& header, ripple::uint256 const& key);
+
+/**
+ * Return the digest of ancestor `seq` of `header`
+ * if the skip lists in its state record it.
+ * Mirrors `ripple::hashOfSeq`.
+ */
+XRPLORER_EXPORT std::optional<ripple::uint256> hashOfSeq(
+    Database& db, ripple::LedgerHeader const& header, std::uint32_t seq);
+
+/**
+ * Return the header of ancestor `seq` of `anchor`,
+ * hopping through skip lists where they reach and parent links where they do not,
+ * or null if the chain is broken.
+ */
+XRPLORER_EXPORT NodePtr findLedger(
+    Database& db, NodePtr const& anchor, std::uint32_t seq);
+
+/**
+ * Return the headers of ancestors `from` to `to` of `anchor`, newest first,
+ * each with its `hash` filled in.
+ * Throws if any of them is missing.
+ */
+XRPLORER_EXPORT std::vector<ripple::LedgerHeader> collectLedgers(
+    Database& db, NodePtr const& anchor, std::uint32_t from, std::uint32_t to);
+
+}
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef XRPLORER_MATERIALIZE_HPP
+#define XRPLORER_MATERIALIZE_HPP
+
+#include <xrplorer/context.hpp>
+#include <xrplorer/database.hpp>
+#include <xrplorer/export.hpp>
+#include <xrplorer/shamap.hpp>
+
+#include <xrpl/basics/base_uint.h>
+#include <xrpl/protocol/LedgerFormats.h> // LedgerEntryType
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace xrplorer {
+
+/**
+ * An allocator that leaves elements default-initialized,
+ * so that sizing a large buffer does not touch its pages
+ * until they are written.
+ */
+template <typename T>
+struct DefaultInitAllocator : std::allocator<T> {
+    template <typename U>
+    struct rebind {
+        using other = DefaultInitAllocator<U>;
+    };
+
+    using std::allocator<T>::allocator;
+
+    template <typename U>
+    void construct(U* p) noexcept(std::is_nothrow_default_constructible_v<U>) {
+        ::new (static_cast<void*>(p)) U;
+    }
+
+    template <typename U, typename... Args>
+    void construct(U* p, Args&&... args) {
+        ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
+};
+
+/**
+ * The whole state of one ledger in memory,
+ * as parallel arrays sorted by key,
+ * with the serialized entries back to back in one buffer.
+ * Ranges are found by binary search and scanned in order,
+ * without fetching or allocating a node.
+ */
+struct XRPLORER_EXPORT MaterializedState {
+    // The digest of the state tree.
+    ripple::uint256 root;
+    std::vector<ripple::uint256> keys;
+    // The `LedgerEntryType` of each entry.
+    std::vector<std::uint16_t> types;
+    // Entry `i` is `blob[offsets[i], offsets[i + 1])`.
+    std::vector<std::uint64_t> offsets;
+    std::vector<std::uint8_t, DefaultInitAllocator<std::uint8_t>> blob;
+
+    std::size_t size() const {
+        return keys.size();
+    }
+
+    Leaf leaf(std::size_t i) const {
+        return {keys[i], ripple::Slice{blob.data() + offsets[i], offsets[i + 1] - offsets[i]}};
+    }
+
+    /** Rebuild the leaf node of entry `i`, digest included. */
+    NodePtr object(std::size_t i) const;
+
+    /** The index of `key`, if the state has it. */
+    std::optional<std::size_t> find(ripple::uint256 const& key) const;
+
+    /** Like `visitLeaves`. */
+    bool visit(
+        KeyRange const& range,
+        std::optional<ripple::LedgerEntryType> type,
+        LeafVisitor const& visitor) const;
+
+    /** Bytes held by the arrays. */
+    std::size_t bytes() const;
+};
+
+/**
+ * Load every leaf of the state tree `root` with a parallel walk
+ * and keep the result with `db`, replacing any other,
+ * so that later leaf scans of that tree are served from memory.
+ * Throws if a node is missing.
+ */
+XRPLORER_EXPORT std::shared_ptr<MaterializedState const> materialize(
+    Database& db,
+    ripple::uint256 const& root,
+    std::optional<unsigned int> walkers = std::nullopt);
+
+/** The state kept with `db`, if it is the tree `root`. */
+XRPLORER_EXPORT std::shared_ptr<MaterializedState const> materialized(
+    Database const& db, ripple::uint256 const& root);
+
+}
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef XRPLORER_OBJECT_HPP
+#define XRPLORER_OBJECT_HPP
+
+#include <xrplorer/export.hpp>
+
+#include <xrpl/basics/base_uint.h>
+#include <xrpl/nodestore/NodeObject.h>
+#include <xrpl/protocol/LedgerHeader.h>
+#include <xrpl/protocol/STBase.h>
+#include <xrpl/protocol/STLedgerEntry.h>
+#include <xrpl/protocol/STObject.h>
+#include <xrpl/protocol/STTx.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <variant>
+#include <vector>
+
+namespace xrplorer {
+
+/** The branches of an inner node. Empty branches are zero. */
+struct XRPLORER_EXPORT InnerNode {
+    ripple::uint256 digest;
+    std::array<ripple::uint256, 16> children;
+};
+
+/** A transaction with its metadata. */
+struct XRPLORER_EXPORT Transaction {
+    std::shared_ptr<ripple::STTx const> tx;
+    std::shared_ptr<ripple::STObject const> meta;
+};
+
+/**
+ * A decoded object at the end of a path:
+ * nothing (e.g. for a directory that is only a namespace),
+ * a ledger header, an inner node, the keys in a key range,
+ * a ledger entry, a transaction, a field, or a scalar.
+ */
+using Object = std::variant<
+    std::monostate,
+    ripple::LedgerHeader,
+    InnerNode,
+    std::vector<ripple::uint256>,
+    std::shared_ptr<ripple::STLedgerEntry const>,
+    Transaction,
+    std::shared_ptr<ripple::STBase const>,
+    std::uint32_t,
+    ripple::uint256>;
+
+struct XRPLORER_EXPORT Resolution {
+    // The node at the end of the path, if it has one.
+    std::shared_ptr<ripple::NodeObject> node;
+    // The decoded object at the end of the path.
+    Object object;
+};
+
+/** Decode an inner node, or return nothing if it is not one. */
+XRPLORER_EXPORT std::optional<InnerNode> decodeInner(
+    std::shared_ptr<ripple::NodeObject> const& object);
+
+/**
+ * Decode a transaction leaf, keeping its metadata.
+ * Throws `Exception` with `TYPE_UNKNOWN` if `object` is not a leaf.
+ */
+XRPLORER_EXPORT Transaction decodeTransaction(
+    std::shared_ptr<ripple::NodeObject> const& object);
+
+/** Copy a field out of the object that holds it. */
+XRPLORER_EXPORT std::shared_ptr<ripple::STBase const> copyField(
+    ripple::STBase const& field);
+
+}
+
+#endif
@@ -18,7 +18,9 @@ private:
     std::filesystem::path cwd_{"/", std::filesystem::path::generic_format};
     std::unordered_map<std::string, std::string> env_;
     std::string hostname_;
-    std::unique_ptr<Database> db_;
+    DatabaseOptions dbOptions_;
+    // Shared by copies, which are sessions over the same node store.
+    std::shared_ptr<Database> db_;
 
 public:
     FILE* stdout;
@@ -34,6 +36,13 @@ public:
 
     std::string_view gethostname() const;
     void sethostname(std::string_view hostname);
+    DatabaseOptions const& getdboptions() const {
+        return dbOptions_;
+    }
+    // Takes effect at the next `sethostname`.
+    void setdboptions(DatabaseOptions const& options) {
+        dbOptions_ = options;
+    }
     Database& db() const {
         return *db_;
     }
@@ -0,0 +1,58 @@
+#ifndef XRPLORER_ORPHANS_HPP
+#define XRPLORER_ORPHANS_HPP
+
+#include <xrplorer/context.hpp>
+#include <xrplorer/database.hpp>
+#include <xrplorer/export.hpp>
+#include <xrplorer/scan.hpp>
+
+#include <xrpl/basics/base_uint.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+
+namespace xrplorer {
+
+struct XRPLORER_EXPORT OrphanTotals {
+    // Nodes reachable from the retained ledgers, headers included.
+    std::uint64_t reachable = 0;
+    // Reachable nodes that are missing from the node store.
+    std::uint64_t missing = 0;
+    // Objects in the node store that no retained ledger reaches.
+    std::uint64_t orphans = 0;
+    // Their size as stored, i.e. compressed.
+    std::uint64_t orphanBytes = 0;
+    ScanTotals scan;
+};
+
+/**
+ * Called once for each orphan, from any of the workers.
+ * `stored` is the size of the object in the data file.
+ */
+using OrphanVisitor = std::function<void(
+    unsigned int worker, ripple::uint256 const& digest, std::size_t stored)>;
+
+/**
+ * Find the objects in the node store at `directory`
+ * that are unreachable from ledgers `from` to `to`, ancestors of `anchor`.
+ *
+ * First, walk every retained ledger to collect the reachable digests.
+ * Ledgers share most of their nodes,
+ * and a subtree already in the set is skipped without fetching it.
+ * Then, scan the keys of the data file and visit every digest not in the set.
+ * Nothing is decoded in the scan.
+ */
+XRPLORER_EXPORT OrphanTotals findOrphans(
+    Database& db,
+    std::filesystem::path const& directory,
+    NodePtr const& anchor,
+    std::uint32_t from,
+    std::uint32_t to,
+    OrphanVisitor const& visitor = {},
+    std::optional<unsigned int> workers = std::nullopt);
+
+}
+
+#endif
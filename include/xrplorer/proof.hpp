@@ -0,0 +1,62 @@
+#ifndef XRPLORER_PROOF_HPP
+#define XRPLORER_PROOF_HPP
+
+#include <xrplorer/context.hpp>
+#include <xrplorer/database.hpp>
+#include <xrplorer/export.hpp>
+
+#include <xrpl/basics/base_uint.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace xrplorer {
+
+/** One inner node on the path from a root to a key. */
+struct XRPLORER_EXPORT ProofLevel {
+    ripple::uint256 digest;
+    // Every branch of the node, empty branches as zero.
+    // The branch on the path is recomputed by a verifier.
+    std::array<ripple::uint256, 16> branches;
+};
+
+/**
+ * The inner nodes from a root down to the slot for `key`.
+ * `leaf` is the leaf in that slot, or null if the slot is empty.
+ * If it holds a different key, the proof shows that `key` is absent.
+ */
+struct XRPLORER_EXPORT Proof {
+    ripple::uint256 key;
+    std::vector<ProofLevel> path;
+    NodePtr leaf;
+
+    bool included() const;
+};
+
+struct XRPLORER_EXPORT ProofBatch {
+    // One per distinct key, sorted by key.
+    std::vector<Proof> proofs;
+    // The nodes fetched to build them.
+    std::uint64_t fetches = 0;
+};
+
+/**
+ * Build proofs for `keys` under the tree with root `root`.
+ *
+ * The keys are sorted, so keys that share a prefix share a path,
+ * and each node on it is fetched once for all of them.
+ * Throws if a node on a path is missing.
+ */
+XRPLORER_EXPORT ProofBatch prove(
+    Database& db, ripple::uint256 const& root, std::vector<ripple::uint256> keys);
+
+/**
+ * Return `true` if the digests of `proof`, hashed from the leaf up,
+ * end in `root`.
+ */
+XRPLORER_EXPORT bool verify(Proof const& proof, ripple::uint256 const& root);
+
+}
+
+#endif
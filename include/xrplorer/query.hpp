@@ -0,0 +1,55 @@
+#ifndef XRPLORER_QUERY_HPP
+#define XRPLORER_QUERY_HPP
+
+#include <xrplorer/database.hpp>
+#include <xrplorer/export.hpp>
+#include <xrplorer/object.hpp>
+#include <xrplorer/operating-system.hpp>
+
+#include <xrpl/basics/base_uint.h>
+#include <xrpl/protocol/AccountID.h>
+#include <xrpl/protocol/LedgerHeader.h>
+#include <xrpl/protocol/STLedgerEntry.h>
+
+#include <memory>
+#include <optional>
+#include <string_view>
+
+/**
+ * Typed lookups for programs that link the library.
+ * Nothing here formats or prints;
+ * missing things are returned empty
+ * and only broken paths throw `Exception`.
+ */
+namespace xrplorer {
+
+/**
+ * Resolve a path in the filesystem hierarchy,
+ * relative to the working directory of `os`,
+ * and decode what is at the end of it.
+ */
+XRPLORER_EXPORT Resolution resolve(OperatingSystem& os, std::string_view path);
+
+/** The header of the ledger with digest `digest`. */
+XRPLORER_EXPORT std::optional<ripple::LedgerHeader> ledger(
+    Database& db, ripple::uint256 const& digest);
+
+/** The inner node with digest `digest`. */
+XRPLORER_EXPORT std::optional<InnerNode> inner(
+    Database& db, ripple::uint256 const& digest);
+
+/** The ledger entry with key `key` in the state of `header`. */
+XRPLORER_EXPORT std::shared_ptr<ripple::STLedgerEntry const> entry(
+    Database& db, ripple::LedgerHeader const& header, ripple::uint256 const& key);
+
+/** The root of `account` in the state of `header`. */
+XRPLORER_EXPORT std::shared_ptr<ripple::STLedgerEntry const> account(
+    Database& db, ripple::LedgerHeader const& header, ripple::AccountID const& account);
+
+/** The transaction with ID `txid` in `header`, with its metadata. */
+XRPLORER_EXPORT std::optional<Transaction> transaction(
+    Database& db, ripple::LedgerHeader const& header, ripple::uint256 const& txid);
+
+}
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef XRPLORER_RETENTION_HPP
+#define XRPLORER_RETENTION_HPP
+
+#include <xrplorer/context.hpp>
+#include <xrplorer/database.hpp>
+#include <xrplorer/export.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+
+namespace xrplorer {
+
+struct XRPLORER_EXPORT LedgerRetention {
+    std::uint32_t seq = 0;
+    // State nodes that no earlier ledger in the range has,
+    // i.e. what a node store must write to keep this ledger.
+    std::uint64_t nodes = 0;
+    // Their size, uncompressed.
+    std::uint64_t bytes = 0;
+    // Subtrees shared with the ledgers before it, counted at their roots,
+    // which the walk skips.
+    // Between consecutive ledgers, nearly all are shared with the parent.
+    std::uint64_t shared = 0;
+    // Nodes that are missing from the node store.
+    std::uint64_t missing = 0;
+    // The nodes and bytes of every ledger in the range up to this one.
+    std::uint64_t workingNodes = 0;
+    std::uint64_t workingBytes = 0;
+};
+
+using RetentionVisitor = std::function<void(LedgerRetention const&)>;
+
+/**
+ * Measure the state nodes that each ledger from `from` to `to`,
+ * ancestors of `anchor`, adds to those of the ledgers before it,
+ * visiting ledgers oldest first.
+ * The first ledger adds its whole state tree.
+ *
+ * Every digest seen is kept in one set.
+ * A subtree whose root is in the set is skipped without fetching it,
+ * so each ledger after the first costs only the nodes it changed.
+ */
+XRPLORER_EXPORT void analyzeRetention(
+    Database& db,
+    NodePtr const& anchor,
+    std::uint32_t from,
+    std::uint32_t to,
+    RetentionVisitor const& visitor,
+    std::optional<unsigned int> walkers = std::nullopt);
+
+}
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef XRPLORER_SCAN_HPP
+#define XRPLORER_SCAN_HPP
+
+#include <xrplorer/context.hpp>
+#include <xrplorer/database.hpp>
+#include <xrplorer/export.hpp>
+
+#include <xrpl/basics/ByteUtilities.h> // megabytes()
+#include <xrpl/basics/base_uint.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <optional>
+#include <vector>
+
+namespace xrplorer {
+
+/**
+ * Called from any of the scanners for every node object in the store.
+ * `worker` is the index of the calling scanner.
+ * `stored` is the size of the object as stored, compressed.
+ */
+using StoreVisitor = std::function<void(
+    unsigned int worker, NodePtr const& object, std::size_t stored)>;
+
+/** Like `StoreVisitor`, for scans that only need the keys. */
+using KeyVisitor = std::function<void(
+    unsigned int worker, ripple::uint256 const& digest, std::size_t stored)>;
+
+struct XRPLORER_EXPORT ScanTotals {
+    // Records in the data file, including spills.
+    std::uint64_t records = 0;
+    // Spill records, which hold key file buckets instead of objects.
+    std::uint64_t spills = 0;
+    // Records that failed to decode,
+    // and a record with an impossible size, at which the scan stops.
+    std::uint64_t corrupt = 0;
+    // Size of the data file.
+    std::uint64_t bytes = 0;
+};
+
+struct XRPLORER_EXPORT PrefixStats {
+    std::uint64_t count = 0;
+    std::uint64_t bytes = 0;
+    std::uint64_t stored = 0;
+};
+
+/** What a scan finds in the store, by `HashPrefix`. */
+struct alignas(64) XRPLORER_EXPORT StoreStats {
+    std::map<std::uint32_t, PrefixStats> prefixes;
+    // The sequences of the ledger headers found, unordered until merged.
+    std::vector<std::uint32_t> ledgers;
+
+    void add(NodePtr const& object, std::size_t stored);
+    // Leaves `ledgers` sorted.
+    void merge(StoreStats const& rhs);
+};
+
+/**
+ * Read every object in the NuDB store at `directory`
+ * from its data file, front to back, in reads of `readSize` bytes,
+ * and decode them on up to `workers` threads
+ * (by default, `DatabaseOptions::walkers`).
+ * The order of visits is unspecified.
+ */
+XRPLORER_EXPORT ScanTotals scanStore(
+    Database const& db,
+    std::filesystem::path const& directory,
+    StoreVisitor const& visitor,
+    std::optional<unsigned int> workers = std::nullopt,
+    std::size_t readSize = ripple::megabytes(4));
+
+/**
+ * Like `scanStore`, but without decoding objects,
+ * to visit only the digests that the store holds.
+ */
+XRPLORER_EXPORT ScanTotals scanKeys(
+    Database const& db,
+    std::filesystem::path const& directory,
+    KeyVisitor const& visitor,
+    std::optional<unsigned int> workers = std::nullopt,
+    std::size_t readSize = ripple::megabytes(4));
+
+}
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef XRPLORER_SELECT_HPP
+#define XRPLORER_SELECT_HPP
+
+#include <xrplorer/database.hpp>
+#include <xrplorer/export.hpp>
+#include <xrplorer/shamap.hpp>
+
+#include <xrpl/basics/Blob.h>
+#include <xrpl/basics/Slice.h>
+#include <xrpl/basics/base_uint.h>
+#include <xrpl/protocol/SField.h>
+
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace xrplorer {
+
+enum class Op { EQ, NE, LT, LE, GT, GE };
+
+/** The part of a field that a condition reads. */
+enum class Part {
+    WHOLE,
+    // Only for amounts, written `Field.currency` and `Field.issuer`.
+    CURRENCY,
+    ISSUER,
+};
+
+struct XRPLORER_EXPORT Condition {
+    ripple::SField const* field;
+    Part part;
+    Op op;
+    // Integers and the values of amounts compare as numbers.
+    bool numeric;
+    long double number;
+    // Everything else compares as bytes,
+    // serialized like the part of the field that they are compared to.
+    ripple::Blob bytes;
+};
+
+/**
+ * A filter over ledger entries, compiled from text like
+ *
+ *     LedgerEntryType == RippleState and Balance.currency == USD
+ *     Balance > 1000000000 or OwnerCount >= 100
+ *
+ * Each condition compares one field by its SField name to a value
+ * written as a number, a hex string, an address, a currency code,
+ * or a `LedgerEntryType` name.
+ * `and` binds tighter than `or`.
+ * A condition on a field that is absent is false.
+ */
+struct XRPLORER_EXPORT Predicate {
+    // Conditions joined by `and`, joined by `or`.
+    std::vector<std::vector<Condition>> clauses;
+    // The fields named in the conditions, and the greatest of their codes.
+    std::vector<ripple::SField const*> fields;
+    int lastCode = 0;
+
+    /** Throws `std::invalid_argument` with a message for the user. */
+    static Predicate compile(std::string_view text);
+
+    /**
+     * Test a leaf against the predicate on its serialized bytes,
+     * without deserializing it
+     * unless it has a field whose size cannot be read from its header.
+     */
+    bool operator() (Leaf const& leaf) const;
+};
+
+/**
+ * Return the value of `field` in a serialized ledger entry,
+ * without its length prefix and without deserializing the entry,
+ * or nothing if it is absent
+ * or follows a field whose size cannot be read from its header.
+ */
+XRPLORER_EXPORT std::optional<ripple::Slice> findField(
+    ripple::Slice data, ripple::SField const& field);
+
+/**
+ * Return the leaves in the tree under `root` that match `predicate`,
+ * sorted by key,
+ * scanning the tree with up to `walkers` threads.
+ * Throws `Exception` with `NODE_MISSING` for a node missing under `root`.
+ */
+XRPLORER_EXPORT std::vector<NodePtr> select(
+    Database& db,
+    ripple::uint256 const& root,
+    Predicate const& predicate,
+    std::optional<unsigned int> walkers = std::nullopt);
+
+}
+
+#endif
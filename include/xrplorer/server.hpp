@@ -0,0 +1,70 @@
+#ifndef XRPLORER_SERVER_HPP
+#define XRPLORER_SERVER_HPP
+
+#include <xrplorer/export.hpp>
+#include <xrplorer/operating-system.hpp>
+
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/**
+ * A server that runs shell commands for clients
+ * over a Unix domain socket.
+ *
+ * A client sends one command line per request, ending in a newline.
+ * The server answers with the size of everything the command printed,
+ * in 8 bytes, big-endian, followed by the output itself,
+ * which may contain any bytes.
+ * After `exit`, the server closes the connection.
+ */
+namespace xrplorer {
+
+// The node store cache of a server, unless the options set one,
+// since its sessions fetch the same nodes over and over.
+constexpr int SERVE_CACHE_SIZE = 65536;
+constexpr int SERVE_CACHE_AGE = 5;
+
+class XRPLORER_EXPORT Server {
+private:
+    OperatingSystem& os_;
+    std::filesystem::path path_;
+    unsigned int threads_;
+
+public:
+    /**
+     * Every session starts as a copy of `os`,
+     * with its own working directory and environment
+     * but the same node store.
+     */
+    Server(OperatingSystem& os, std::filesystem::path path, unsigned int threads);
+
+    /**
+     * Serve sessions on `threads` threads until interrupted.
+     * Replaces a socket at the path only if no server is listening on it,
+     * and throws if anything else is there.
+     */
+    void run();
+};
+
+class XRPLORER_EXPORT Client {
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+
+public:
+    Client(std::filesystem::path const& path);
+    ~Client();
+
+    /**
+     * Run one command line on the server and return its output,
+     * or nothing if the server closed the session.
+     */
+    std::optional<std::string> request(std::string_view line);
+};
+
+}
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef XRPLORER_SHAMAP_HPP
+#define XRPLORER_SHAMAP_HPP
+
+#include <xrplorer/context.hpp>
+#include <xrplorer/database.hpp>
+#include <xrplorer/export.hpp>
+#include <xrplorer/shims.hpp>
+
+#include <xrpl/basics/Slice.h>
+#include <xrpl/basics/base_uint.h>
+#include <xrpl/protocol/LedgerFormats.h> // LedgerEntryType
+
+#include <functional>
+#include <optional>
+#include <string_view>
+
+namespace xrplorer {
+
+constexpr unsigned int NBYTES_DIGEST = 256 / 8;
+constexpr unsigned int NBYTES_PREFIX = 4;
+// One-past-end depth is 256 / 4 = 64.
+constexpr unsigned int MAX_DEPTH = 64;
+
+/**
+ * An inclusive range of keys.
+ * The default range covers every key.
+ */
+struct XRPLORER_EXPORT KeyRange {
+    ripple::uint256 first{};
+    ripple::uint256 last{~ripple::uint256{}};
+
+    bool empty() const {
+        return last < first;
+    }
+    bool contains(ripple::uint256 const& key) const {
+        return !(key < first) && !(last < key);
+    }
+
+    /**
+     * Parse a range from a path name.
+     * A name is either a hexadecimal key prefix (e.g. `0A3F`),
+     * or two prefixes separated by `..` (e.g. `0A..0C`),
+     * where either side may be omitted.
+     * The lower side is padded with `0` and the upper side with `F`.
+     */
+    static std::optional<KeyRange> parse(std::string_view name);
+};
+
+XRPLORER_EXPORT KeyRange intersect(KeyRange const& a, KeyRange const& b);
+
+/**
+ * A view of a leaf in a SHAMap.
+ * `data` is the serialized item, without prefix or key suffix.
+ * It is valid only for the duration of a visit.
+ */
+struct XRPLORER_EXPORT Leaf {
+    ripple::uint256 key;
+    ripple::Slice data;
+
+    ripple::SLE sle() const;
+};
+
+/** Split a leaf node into key and item, or return nothing if it is not a leaf. */
+XRPLORER_EXPORT std::optional<Leaf> splitLeaf(NodePtr const& object);
+
+/**
+ * Read the `LedgerEntryType` of a serialized ledger entry
+ * without deserializing it.
+ * `sfLedgerEntryType` has the smallest possible field code
+ * and is always serialized first.
+ */
+XRPLORER_EXPORT std::optional<ripple::LedgerEntryType> peekType(ripple::Slice const& item);
+
+/** Parse a `LedgerEntryType` by name (e.g. `Offer`) or number (e.g. `0x006F`). */
+XRPLORER_EXPORT std::optional<ripple::LedgerEntryType> parseType(std::string_view name);
+XRPLORER_EXPORT std::string_view typeName(ripple::LedgerEntryType type);
+
+/**
+ * Return the digest at `branch` of an inner node,
+ * which is zero for an empty branch,
+ * or nothing if the node is not an inner node.
+ */
+XRPLORER_EXPORT std::optional<ripple::uint256> branchDigest(
+    NodePtr const& object, unsigned int branch);
+
+/** Return `false` to stop the walk. */
+using LeafVisitor = std::function<bool(Leaf const&)>;
+
+/**
+ * Visit, in key order, every leaf under `root` with a key in `range`
+ * and, if given, an entry of `type`.
+ * Descends only the branches whose nibble ranges intersect `range`.
+ * Returns `false` if the visitor stopped the walk.
+ * Throws `Exception` with `NODE_MISSING` for a node missing under `root`.
+ */
+XRPLORER_EXPORT bool visitLeaves(
+    Database& db,
+    NodePtr const& root,
+    KeyRange const& range,
+    std::optional<ripple::LedgerEntryType> type,
+    LeafVisitor const& visitor);
+
+/**
+ * Return the leaf for `key` under `root`, or null if there is none.
+ * Throws `Exception` with `NODE_MISSING` for a node missing on the way.
+ */
+XRPLORER_EXPORT NodePtr findLeaf(
+    Database& db, NodePtr const& root, ripple::uint256 const& key);
+
+}
+
+#endif
@@ -5,6 +5,8 @@
 #include <xrplorer/operating-system.hpp>
 
 #include <cstdio>
+#include <optional>
+#include <string>
 #include <string_view>
 
 namespace xrplorer {
@@ -18,15 +20,41 @@ public:
 
     int main(int argc, char** argv);
 
+    /**
+     * Run one command line.
+     * Returns the exit status if the command ends the session.
+     */
+    std::optional<int> execute(std::string const& cmdline);
+
 private:
+    // Forward command lines to a server instead of running them here.
+    int connect(std::string const& path);
+
+    int bench(int argc, char** argv);
     int cat(int argc, char** argv);
     int cd(int argc, char** argv);
     int echo(int argc, char** argv);
+    int exists(int argc, char** argv);
     int exit(int argc, char** argv);
+    // `export` is a keyword.
+    int export_(int argc, char** argv);
+    int extractTxns(int argc, char** argv);
     int help(int argc, char** argv);
+    int history(int argc, char** argv);
     int hostname(int argc, char** argv);
     int ls(int argc, char** argv);
+    int materialize(int argc, char** argv);
+    int orphans(int argc, char** argv);
+    int proof(int argc, char** argv);
     int pwd(int argc, char** argv);
+    int replay(int argc, char** argv);
+    int retention(int argc, char** argv);
+    int scan(int argc, char** argv);
+    int select(int argc, char** argv);
+    int snapshot(int argc, char** argv);
+    int stat(int argc, char** argv);
+    int trace(int argc, char** argv);
+    int unset(int argc, char** argv);
 };
 
 }
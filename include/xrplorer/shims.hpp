@@ -0,0 +1,50 @@
+#ifndef XRPLORER_SHIMS_HPP
+#define XRPLORER_SHIMS_HPP
+
+#include <xrplorer/export.hpp>
+
+#include <fmt/core.h>
+#include <xrpl/basics/Slice.h>
+#include <xrpl/basics/base_uint.h>
+#include <xrpl/nodestore/NodeObject.h>
+#include <xrpl/protocol/HashPrefix.h>
+#include <xrpl/protocol/Keylet.h>
+#include <xrpl/protocol/LedgerFormats.h> // LedgerEntryType
+#include <xrpl/protocol/LedgerHeader.h>
+#include <xrpl/protocol/STLedgerEntry.h>
+#include <xrpl/protocol/STObject.h>
+
+#include <cstddef>
+#include <memory>
+
+// Shims over libxrpl for things it either hides inside `SHAMap`
+// or does not have at all.
+namespace ripple {
+
+using NodePtr = std::shared_ptr<NodeObject>;
+using SLE = STLedgerEntry;
+
+template <std::size_t Bits, class Tag>
+auto format_as(base_uint<Bits, Tag> const& uint) {
+    return to_string(uint);
+}
+XRPLORER_EXPORT std::string format_as(NodeObjectType const& type);
+XRPLORER_EXPORT std::string format_as(LedgerEntryType type);
+XRPLORER_EXPORT std::string format_as(HashPrefix prefix);
+
+XRPLORER_EXPORT HashPrefix deserializePrefix(NodePtr const& object);
+XRPLORER_EXPORT LedgerHeader deserializePrefixedHeader(NodePtr const& object);
+
+struct SHAMapInnerNode {
+    static constexpr unsigned int branchFactor = 16;
+};
+
+XRPLORER_EXPORT unsigned int selectBranch(uint256 const& key, unsigned int depth);
+
+XRPLORER_EXPORT SLE make_sle(NodePtr const& object);
+XRPLORER_EXPORT SLE make_sle(Keylet const& keylet, NodePtr const& object);
+XRPLORER_EXPORT STObject make_txm(NodePtr const& object);
+
+}
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef XRPLORER_SNAPSHOT_HPP
+#define XRPLORER_SNAPSHOT_HPP
+
+#include <xrplorer/context.hpp>
+#include <xrplorer/database.hpp>
+#include <xrplorer/export.hpp>
+
+#include <cstdint>
+#include <filesystem>
+
+/**
+ * A snapshot is one read-only file holding every node of one ledger:
+ * its header, its state tree and its transaction tree.
+ * All integers are little-endian.
+ *
+ *     [0, 64)            header
+ *         magic "XRPLSNAP" (8), version (4), reserved (4),
+ *         count of records (8), offset of the index (8),
+ *         digest of the ledger header (32)
+ *     [64, index)        records, depth-first from the ledger header
+ *         type (1), encoding (1), size of payload (4), payload
+ *     [index, end)       index, sorted by digest
+ *         digest (32), offset of record (8)
+ *
+ * A payload is either the node data as is (encoding 0),
+ * or, for an inner node, a 16-bit branch mask
+ * followed by the digests of the non-empty branches (encoding 1).
+ */
+namespace xrplorer {
+
+struct XRPLORER_EXPORT SnapshotStats {
+    std::uint64_t nodes = 0;
+    // Size of the file.
+    std::uint64_t bytes = 0;
+};
+
+/** Write a snapshot of the ledger `header` to `path`. */
+XRPLORER_EXPORT SnapshotStats writeSnapshot(
+    Database& db, NodePtr const& header, std::filesystem::path const& path);
+
+/** Return whether `path` names a snapshot file. */
+XRPLORER_EXPORT bool isSnapshot(std::filesystem::path const& path);
+
+/** The name of the node store backend type that reads snapshots. */
+constexpr char const* SNAPSHOT_TYPE = "Snapshot";
+
+}
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef XRPLORER_STAT_HPP
+#define XRPLORER_STAT_HPP
+
+#include <xrplorer/database.hpp>
+#include <xrplorer/export.hpp>
+#include <xrplorer/shamap.hpp>
+
+#include <xrpl/basics/base_uint.h>
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <optional>
+
+namespace xrplorer {
+
+/** Sizes are bucketed by bit width: bucket `b` holds sizes in [2^(b-1), 2^b). */
+using SizeHistogram = std::array<std::uint64_t, 33>;
+
+struct XRPLORER_EXPORT TypeStats {
+    std::uint64_t count = 0;
+    // Serialized size of the entry, without prefix or key.
+    std::uint64_t bytes = 0;
+    std::uint64_t min = UINT64_MAX;
+    std::uint64_t max = 0;
+    SizeHistogram sizes{};
+
+    void add(std::uint64_t size);
+    void merge(TypeStats const& rhs);
+};
+
+// Aligned so that walkers do not share cache lines.
+struct XRPLORER_EXPORT alignas(64) TreeStats {
+    // Keyed by `LedgerEntryType`.
+    // Leaves that are not ledger entries (i.e. transactions)
+    // are keyed by their `HashPrefix`, which is outside the 16-bit range.
+    std::map<std::uint32_t, TypeStats> types;
+    std::array<std::uint64_t, MAX_DEPTH + 1> innersByDepth{};
+    std::array<std::uint64_t, MAX_DEPTH + 1> leavesByDepth{};
+    // Inner nodes by number of children.
+    std::array<std::uint64_t, 17> fanout{};
+    std::uint64_t innerBytes = 0;
+    std::uint64_t missing = 0;
+
+    void merge(TreeStats const& rhs);
+};
+
+/**
+ * Profile the tree under `root` in one parallel pass.
+ * Leaves are classified from their raw bytes without deserializing them.
+ * Each walker fills its own `TreeStats`, and they are merged at the end.
+ */
+XRPLORER_EXPORT TreeStats statTree(
+    Database& db,
+    ripple::uint256 const& root,
+    std::optional<unsigned int> walkers = std::nullopt);
+
+}
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef XRPLORER_TRACE_HPP
+#define XRPLORER_TRACE_HPP
+
+#include <xrplorer/database.hpp>
+#include <xrplorer/export.hpp>
+
+#include <xrpl/basics/base_uint.h>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+/**
+ * A trace is a binary log of the fetches from a node store,
+ * in the order that they finished.
+ * All integers are little-endian.
+ *
+ *     [0, 16)            header
+ *         magic "XRPLTRCE" (8), version (4), reserved (4)
+ *     [16, end)          records
+ *         digest (32), nanoseconds from the start of the trace
+ *         to the start of the fetch (8), latency in nanoseconds (4),
+ *         size of the object, or zero if it was missing (4)
+ */
+namespace xrplorer {
+
+struct XRPLORER_EXPORT TraceRecord {
+    ripple::uint256 digest;
+    std::uint64_t start = 0;
+    std::uint32_t latency = 0;
+    std::uint32_t size = 0;
+};
+
+/** Appends records to a trace file. Safe to call from any thread. */
+class XRPLORER_EXPORT TraceWriter {
+private:
+    std::filesystem::path path_;
+    std::chrono::steady_clock::time_point epoch_;
+    std::mutex mutex_;
+    std::ofstream out_;
+    std::vector<std::uint8_t> buffer_;
+    std::uint64_t count_ = 0;
+
+    void flush();
+
+public:
+    /** Throws `Exception` if the file cannot be written. */
+    TraceWriter(std::filesystem::path path);
+    ~TraceWriter();
+
+    void record(
+        ripple::uint256 const& digest,
+        std::chrono::steady_clock::time_point start,
+        std::chrono::nanoseconds latency,
+        std::size_t size);
+
+    std::filesystem::path const& path() const {
+        return path_;
+    }
+
+    /**
+     * Flush the file and return the number of records written.
+     * Throws `Exception` if any write to it failed.
+     */
+    std::uint64_t close();
+};
+
+/** Read every record of a trace. Throws `Exception` if it is not one. */
+XRPLORER_EXPORT std::vector<TraceRecord> readTrace(std::filesystem::path const& path);
+
+struct XRPLORER_EXPORT ReplayStats {
+    std::uint64_t fetches = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t bytes = 0;
+    double seconds = 0;
+    // Nanoseconds, sorted.
+    std::vector<std::uint32_t> latencies;
+};
+
+/**
+ * Fetch the digests of `trace` from `db` in order,
+ * with up to `threads` fetches in flight,
+ * as fast as the node store allows.
+ */
+XRPLORER_EXPORT ReplayStats replayTrace(
+    Database& db, std::vector<TraceRecord> const& trace, unsigned int threads);
+
+/** The `q`-quantile of sorted `values`, or zero if there are none. */
+XRPLORER_EXPORT std::uint32_t percentile(
+    std::vector<std::uint32_t> const& values, double q);
+
+}
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef XRPLORER_WALK_HPP
+#define XRPLORER_WALK_HPP
+
+#include <xrplorer/context.hpp>
+#include <xrplorer/database.hpp>
+#include <xrplorer/export.hpp>
+
+#include <xrpl/basics/base_uint.h>
+
+#include <functional>
+#include <optional>
+#include <vector>
+
+namespace xrplorer {
+
+/**
+ * Called once for each node in a walk, from any of the walkers.
+ * `worker` is the index of the calling walker,
+ * for callers that keep per-walker state without locks.
+ * `object` is null when the node is missing from the store.
+ * Return `false` to skip the children of the node.
+ */
+using NodeVisitor = std::function<bool(
+    unsigned int worker,
+    ripple::uint256 const& digest,
+    NodePtr const& object,
+    unsigned int depth)>;
+
+/**
+ * Called before a node is fetched.
+ * Return `false` to skip the node and everything under it.
+ */
+using DigestFilter = std::function<bool(ripple::uint256 const& digest)>;
+
+/**
+ * The digests of the children of a node:
+ * the non-empty branches of an inner node,
+ * or the state and transaction roots of a ledger header.
+ */
+XRPLORER_EXPORT std::vector<ripple::uint256> children(NodePtr const& object);
+
+/**
+ * Walk the trees under `roots` depth-first
+ * with up to `walkers` threads fetching at once.
+ * By default, that is `Database::concurrency()`,
+ * re-read as the walk progresses when the limit is adaptive.
+ * Nodes that `filter` rejects are neither fetched nor visited.
+ * Returns the number of walkers started,
+ * which bounds the `worker` passed to the visitor.
+ */
+XRPLORER_EXPORT unsigned int walk(
+    Database& db,
+    std::vector<ripple::uint256> const& roots,
+    NodeVisitor const& visitor,
+    std::optional<unsigned int> walkers = std::nullopt,
+    DigestFilter const& filter = {});
+
+/** The number of walkers that `walk` will start. */
+XRPLORER_EXPORT unsigned int countWalkers(
+    Database const& db, std::optional<unsigned int> walkers = std::nullopt);
+
+}
+
+#endif
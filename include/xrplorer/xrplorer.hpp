@@ -2,6 +2,8 @@
 #define XRPLORER_XRPLORER_HPP
 
 #include <xrplorer/operating-system.hpp>
+#include <xrplorer/query.hpp>
+#include <xrplorer/server.hpp>
 #include <xrplorer/shell.hpp>
 
 #endif
@@ -0,0 +1,241 @@
+#include <xrplorer/book.hpp>
+#include <xrplorer/materialize.hpp>
+#include <xrplorer/shamap.hpp>
+
+#include <fmt/core.h>
+#include <xrpl/protocol/AccountID.h>
+#include <xrpl/protocol/Indexes.h>
+#include <xrpl/protocol/SField.h>
+#include <xrpl/protocol/UintTypes.h>
+
+#include <algorithm>
+#include <deque>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace xrplorer {
+
+std::optional<ripple::Issue> parseIssue(std::string_view name) {
+    if (name == "XRP") {
+        return ripple::xrpIssue();
+    }
+    auto dot = name.find('.');
+    if (dot == std::string_view::npos) {
+        return std::nullopt;
+    }
+    ripple::Currency currency;
+    if (!ripple::to_currency(currency, std::string{name.substr(0, dot)})
+        || ripple::isXRP(currency))
+    {
+        return std::nullopt;
+    }
+    auto issuer = ripple::parseBase58<ripple::AccountID>(std::string{name.substr(dot + 1)});
+    if (!issuer) {
+        return std::nullopt;
+    }
+    return ripple::Issue{currency, *issuer};
+}
+
+std::string formatIssue(ripple::Issue const& issue) {
+    if (ripple::isXRP(issue.currency)) {
+        return "XRP";
+    }
+    return fmt::format("{}.{}",
+        ripple::to_string(issue.currency), ripple::toBase58(issue.account));
+}
+
+// Inner nodes this close to the root are kept for every lookup in a visit,
+// which they nearly all share.
+constexpr unsigned int SHARED_DEPTH = 3;
+
+/**
+ * Finds leaves by key under one root
+ * with the asynchronous reads of the node store,
+ * fetching the nodes near the root only once.
+ * Every lookup must complete before the finder is destroyed.
+ */
+class LeafFinder {
+private:
+    struct Lookup {
+        ripple::uint256 key;
+        std::promise<NodePtr> promise;
+    };
+
+    Database& db_;
+    NodePtr root_;
+    std::mutex mutex_;
+    std::map<ripple::uint256, NodePtr> shared_;
+
+public:
+    LeafFinder(Database& db, NodePtr root) : db_(db), root_(std::move(root)) {}
+
+    /**
+     * Return the leaf for `key`, or null if there is none.
+     * The future throws `Exception` with `NODE_MISSING`
+     * for a node missing on the way.
+     */
+    std::future<NodePtr> find(ripple::uint256 const& key) {
+        auto lookup = std::make_shared<Lookup>(key);
+        auto future = lookup->promise.get_future();
+        // Without read threads, or with the state in memory,
+        // a lookup costs nothing to do in place.
+        if (db_.options_.readThreads < 1 || materialized(db_, root_->getHash())) {
+            try {
+                lookup->promise.set_value(findLeaf(db_, root_, key));
+            } catch (...) {
+                lookup->promise.set_exception(std::current_exception());
+            }
+            return future;
+        }
+        descend(lookup, root_, 0);
+        return future;
+    }
+
+private:
+    /** Continue `lookup` from `object` at `depth`, fetching at most one node. */
+    void descend(std::shared_ptr<Lookup> const& lookup, NodePtr object, unsigned int depth) {
+        try {
+            for (; depth < MAX_DEPTH; ++depth) {
+                auto child = branchDigest(object, ripple::selectBranch(lookup->key, depth));
+                if (!child) {
+                    break;
+                }
+                if (*child == beast::zero) {
+                    return lookup->promise.set_value(nullptr);
+                }
+                if (depth + 1 < SHARED_DEPTH) {
+                    std::lock_guard lock{mutex_};
+                    if (auto it = shared_.find(*child); it != shared_.end()) {
+                        object = it->second;
+                        continue;
+                    }
+                }
+                db_.asyncFetch(*child,
+                    [this, lookup, digest = *child, depth](NodePtr const& object) {
+                        if (!object) {
+                            return lookup->promise.set_exception(std::make_exception_ptr(
+                                Exception{NODE_MISSING, fmt::format("/nodes/{}", digest), "node missing"}));
+                        }
+                        if (depth + 1 < SHARED_DEPTH) {
+                            std::lock_guard lock{mutex_};
+                            shared_.emplace(digest, object);
+                        }
+                        descend(lookup, object, depth + 1);
+                    });
+                return;
+            }
+            auto leaf = splitLeaf(object);
+            lookup->promise.set_value((leaf && leaf->key == lookup->key) ? object : nullptr);
+        } catch (...) {
+            lookup->promise.set_exception(std::current_exception());
+        }
+    }
+};
+
+static Exception entryMissing(ripple::uint256 const& key) {
+    return Exception{NODE_MISSING, to_string(key), "entry missing"};
+}
+
+bool visitBook(
+    Database& db,
+    NodePtr const& root,
+    ripple::Book const& book,
+    OfferVisitor const& visitor,
+    std::optional<unsigned int> lookahead)
+{
+    auto depth = std::max(lookahead.value_or(db.concurrency()), 1u);
+
+    // The first page of each quality directory in the book
+    // is keyed by the book base plus the quality,
+    // so they sort best quality first,
+    // and one walk of that range reads them all.
+    auto base = ripple::getBookBase(book);
+    auto next = ripple::getQualityNext(base);
+    std::vector<ripple::SLE> directories;
+    visitLeaves(db, root, KeyRange{base, --next}, ripple::ltDIR_NODE,
+        [&](Leaf const& leaf) {
+            directories.push_back(leaf.sle());
+            return true;
+        });
+
+    LeafFinder finder{db, root};
+    auto directory = directories.begin();
+    ripple::uint256 directoryRoot;
+    ripple::uint256 pageKey;
+    std::future<NodePtr> page;
+    std::deque<std::pair<ripple::uint256, std::future<NodePtr>>> offers;
+    // Let every lookup finish before the finder goes,
+    // however the visit ends.
+    struct Drain {
+        std::future<NodePtr>& page;
+        std::deque<std::pair<ripple::uint256, std::future<NodePtr>>>& offers;
+        ~Drain() {
+            if (page.valid()) {
+                page.wait();
+            }
+            for (auto& [key, offer] : offers) {
+                offer.wait();
+            }
+        }
+    } drain{page, offers};
+
+    // Queue the offers on the current page and start fetching the next.
+    // Returns `false` when there are no pages left.
+    std::deque<ripple::uint256> keys;
+    auto nextPage = [&]() {
+        std::optional<ripple::SLE> sle;
+        if (page.valid()) {
+            auto object = page.get();
+            if (!object) {
+                throw entryMissing(pageKey);
+            }
+            sle.emplace(splitLeaf(object)->sle());
+        } else if (directory != directories.end()) {
+            sle.emplace(*directory++);
+            directoryRoot = sle->key();
+        } else {
+            return false;
+        }
+        auto index = sle->isFieldPresent(ripple::sfIndexNext)
+            ? sle->getFieldU64(ripple::sfIndexNext)
+            : 0;
+        if (index != 0) {
+            pageKey = ripple::keylet::page(directoryRoot, index).key;
+            page = finder.find(pageKey);
+        }
+        for (auto const& key : sle->getFieldV256(ripple::sfIndexes)) {
+            keys.push_back(key);
+        }
+        return true;
+    };
+
+    while (true) {
+        while (offers.size() < depth) {
+            if (keys.empty() && !nextPage()) {
+                break;
+            }
+            if (!keys.empty()) {
+                offers.emplace_back(keys.front(), finder.find(keys.front()));
+                keys.pop_front();
+            }
+        }
+        if (offers.empty()) {
+            return true;
+        }
+        auto [key, offer] = std::move(offers.front());
+        offers.pop_front();
+        auto object = offer.get();
+        if (!object) {
+            throw entryMissing(key);
+        }
+        if (!visitor(splitLeaf(object)->sle())) {
+            return false;
+        }
+    }
+}
+
+}
@@ -0,0 +1,48 @@
+#include <xrplorer/concurrency.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace xrplorer {
+
+ConcurrencyLimit::ConcurrencyLimit(unsigned int max, bool adaptive)
+    : max_(std::max(max, 1u))
+    , adaptive_(adaptive)
+    // An adaptive limit starts low and climbs.
+    , limit_(adaptive ? std::min(max_, 4u) : max_)
+{}
+
+void ConcurrencyLimit::sample(std::chrono::nanoseconds latency) {
+    if (!adaptive_) {
+        return;
+    }
+    nanos_.fetch_add(latency.count(), std::memory_order_relaxed);
+    if (samples_.fetch_add(1, std::memory_order_relaxed) + 1 < WINDOW) {
+        return;
+    }
+    // Only one thread adjusts. The rest carry on.
+    std::unique_lock lock{mutex_, std::try_to_lock};
+    if (!lock) {
+        return;
+    }
+    auto samples = samples_.exchange(0, std::memory_order_relaxed);
+    auto nanos = nanos_.exchange(0, std::memory_order_relaxed);
+    if (samples == 0) {
+        return;
+    }
+    double average = static_cast<double>(nanos) / samples;
+    // Let the floor drift up slowly so that it can track
+    // a device whose unloaded latency changes (e.g. a cache cooling).
+    floor_ = (floor_ == 0) ? average : std::min(floor_ * 1.01, average);
+    double limit = get();
+    double gradient = std::clamp(floor_ / average, 0.5, 1.0);
+    double next = limit * gradient + std::sqrt(limit);
+    // Smooth the change.
+    next = 0.8 * limit + 0.2 * next;
+    // Round away from the current limit so that small steps still move it.
+    next = (next > limit) ? std::ceil(next) : std::floor(next);
+    next = std::clamp(next, 1.0, static_cast<double>(max_));
+    limit_.store(static_cast<unsigned int>(next), std::memory_order_relaxed);
+}
+
+}
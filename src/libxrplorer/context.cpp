@@ -1,11 +1,23 @@
 #include <xrplorer/context.hpp>
+#include <xrplorer/walk.hpp>
 
 #include <fmt/core.h>
+#include <xrpl/json/Output.h>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fnmatch.h>
 #include <functional> // divides
+#include <iterator>
+#include <mutex>
 #include <numeric> // accumulate
 #include <string>
 #include <string_view>
+#include <thread>
 #include <vector>
 
 namespace xrplorer {
@@ -39,7 +51,151 @@ void Context::skipEmpty() {
     for (; it != path.end() && (*it == "" || *it == "."); ++it);
 }
 
+bool Context::atGlob() const {
+    return it->native().find_first_of("*?[") != std::string::npos;
+}
+
+// Set in the threads that follow the matches of a glob,
+// so that nested globs are followed serially in the same thread.
+static thread_local bool inBranch = false;
+
+struct Branch {
+    fs::path path;
+    char* buffer = nullptr;
+    std::size_t size = 0;
+    std::exception_ptr error;
+    bool done = false;
+};
+
+void Context::expand(
+    std::function<std::vector<std::string>()> const& list,
+    std::function<void(Context&, fs::path const&)> const& open)
+{
+    auto const& pattern = it->native();
+    std::vector<std::string> matches;
+    for (auto name : list()) {
+        if (name.starts_with('<')) {
+            continue;
+        }
+        // Links are listed as "name -> target".
+        auto arrow = name.find(" -> ");
+        if (arrow != std::string::npos) {
+            name.resize(arrow);
+        }
+        if (::fnmatch(pattern.c_str(), name.c_str(), FNM_PERIOD) == 0) {
+            matches.push_back(std::move(name));
+        }
+    }
+    auto depth = std::distance(path.begin(), it);
+    auto before = make_path(path.begin(), it);
+    auto after = make_path(std::next(it), path.end());
+    ++it;
+    if (matches.empty()) {
+        throw notExists();
+    }
+    if ((action == CD || action == RESOLVE) && matches.size() > 1) {
+        throw throw_(AMBIGUOUS, "ambiguous");
+    }
+
+    std::vector<Branch> branches(matches.size());
+    // Follow match `i`, writing to `out_`.
+    auto follow = [&](std::size_t i, FILE* out_) {
+        auto& branch_ = branches[i];
+        branch_.path = after.empty() ? before / matches[i] : before / matches[i] / after;
+        auto bit = std::next(branch_.path.begin(), depth + 1);
+        Context branch{
+            .os = os,
+            .argument = argument,
+            .path = branch_.path,
+            .it = std::move(bit),
+            .action = action,
+            .out = out_,
+            .prefix = prefix,
+            .root = root,
+        };
+        try {
+            open(branch, matches[i]);
+        } catch (...) {
+            branch_.error = std::current_exception();
+        }
+        if (action == RESOLVE) {
+            found = std::move(branch.found);
+        }
+    };
+
+    auto nthreads = std::min<std::size_t>(countWalkers(os.db()), branches.size());
+    if (inBranch || nthreads < 2) {
+        for (std::size_t i = 0; i < branches.size(); ++i) {
+            follow(i, out);
+        }
+    } else {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::atomic<std::size_t> next{0};
+        auto work = [&]() {
+            inBranch = true;
+            for (auto i = next++; i < branches.size(); i = next++) {
+                auto& branch_ = branches[i];
+                auto buffer = ::open_memstream(&branch_.buffer, &branch_.size);
+                if (buffer) {
+                    follow(i, buffer);
+                    std::fclose(buffer);
+                } else {
+                    branch_.error = std::make_exception_ptr(
+                        Exception{WRITE_FAILED, before / matches[i], "cannot buffer output"});
+                }
+                std::lock_guard lock{mutex};
+                branch_.done = true;
+                cv.notify_all();
+            }
+        };
+        std::vector<std::thread> threads;
+        threads.reserve(nthreads);
+        for (std::size_t i = 0; i < nthreads; ++i) {
+            threads.emplace_back(work);
+        }
+        // Write each branch as soon as it and every branch before it are done.
+        for (auto& branch_ : branches) {
+            {
+                std::unique_lock lock{mutex};
+                cv.wait(lock, [&]() { return branch_.done; });
+            }
+            std::fwrite(branch_.buffer, 1, branch_.size, out);
+            std::free(branch_.buffer);
+            branch_.buffer = nullptr;
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+    for (auto const& branch_ : branches) {
+        if (branch_.error) {
+            std::rethrow_exception(branch_.error);
+        }
+    }
+}
+
+bool Context::wantsJson() const {
+    return os.getenv("FORMAT") == "json";
+}
+
 void Context::list(std::vector<std::string> const& names) {
+    if (wantsJson()) {
+        Json::Value array{Json::arrayValue};
+        for (auto const& name : names) {
+            // Links are listed as "name -> target".
+            auto arrow = name.find(" -> ");
+            if (arrow == std::string::npos) {
+                array.append(name);
+                continue;
+            }
+            Json::Value link{Json::objectValue};
+            link["name"] = name.substr(0, arrow);
+            link["target"] = name.substr(arrow + 4);
+            array.append(link);
+        }
+        return print(array);
+    }
     // TODO: Conditional long listing.
     // TODO: Sort alphabetically?
     for (auto const& name : names) {
@@ -49,7 +205,20 @@ void Context::list(std::vector<std::string> const& names) {
 }
 
 void Context::echo(std::string_view text) {
-    fmt::print(os.stdout, "{}\n", text);
+    fmt::print(out, "{}\n", text);
+}
+
+void printJson(FILE* out, Json::Value const& value) {
+    // Stream straight into the output
+    // instead of building the whole document as a string first.
+    Json::stream(value, [out](auto const& chunk) {
+        std::fwrite(chunk.data(), 1, chunk.size(), out);
+    });
+    std::fputc('\n', out);
+}
+
+void Context::print(Json::Value const& value) {
+    printJson(out, value);
 }
 
 }
@@ -1,27 +1,97 @@
 #include <xrplorer/database.hpp>
+#include <xrplorer/snapshot.hpp>
+#include <xrplorer/trace.hpp>
 
-#include <xrpl/basics/ByteUtilities.h> // megabytes()
 #include <xrpl/nodestore/Manager.h>
 #include <xrpl/nodestore/backend/NuDBFactory.h>
 
+#include <chrono>
 #include <cstdint>
+#include <string>
 
 namespace xrplorer {
 
 static ripple::NodeStore::NuDBFactory theNudbFactory;
 
-Database::Database(std::filesystem::path path) {
-    int readThreads{4};
-    std::size_t burstSize{ripple::megabytes(32)};
+Database::Database(std::filesystem::path path, DatabaseOptions const& options)
+    : options_(options)
+{
     ripple::Section section;
-    section.set("type", "NuDB");
+    section.set("type", isSnapshot(path) ? SNAPSHOT_TYPE : "NuDB");
     section.set("path", path);
+    if (options_.cacheSize > 0 || options_.cacheAge > 0) {
+        section.set("cache_size", std::to_string(options_.cacheSize));
+        section.set("cache_age", std::to_string(options_.cacheAge));
+    }
     db_ = ripple::NodeStore::Manager::instance().make_Database(
-            burstSize,
+            options_.burstSize,
             scheduler_,
-            readThreads,
+            options_.readThreads,
             section,
             journal_);
 }
 
+/** Count a fetch, and trace it if tracing. */
+static void account(
+    Database& db,
+    ripple::uint256 const& digest,
+    std::chrono::steady_clock::time_point start,
+    std::chrono::nanoseconds latency,
+    std::shared_ptr<ripple::NodeObject> const& object)
+{
+    db.fetches_.fetch_add(1, std::memory_order_relaxed);
+    db.nanos_.fetch_add(latency.count(), std::memory_order_relaxed);
+    if (object) {
+        db.bytes_.fetch_add(object->getData().size(), std::memory_order_relaxed);
+    } else {
+        db.misses_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (db.tracing_.load(std::memory_order_relaxed)) {
+        if (auto trace = db.trace_.load()) {
+            trace->record(digest, start, latency, object ? object->getData().size() : 0);
+        }
+    }
+}
+
+std::shared_ptr<ripple::NodeObject> Database::fetch(ripple::uint256 const& digest) {
+    auto start = std::chrono::steady_clock::now();
+    auto object = db_->fetchNodeObject(digest);
+    auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start);
+    limit_.sample(latency);
+    account(*this, digest, start, latency, object);
+    return object;
+}
+
+void Database::asyncFetch(
+    ripple::uint256 const& digest,
+    std::function<void(std::shared_ptr<ripple::NodeObject> const&)> callback)
+{
+    auto start = std::chrono::steady_clock::now();
+    // The latency includes the wait for a read thread,
+    // so it is not sampled for the concurrency limit.
+    db_->asyncFetch(digest, 0,
+        [this, digest, start, callback = std::move(callback)](
+            std::shared_ptr<ripple::NodeObject> const& object) {
+            auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start);
+            account(*this, digest, start, latency, object);
+            callback(object);
+        });
+}
+
+std::shared_ptr<TraceWriter> Database::trace(std::shared_ptr<TraceWriter> trace) {
+    tracing_ = !!trace;
+    return trace_.exchange(std::move(trace));
+}
+
+FetchStats Database::stats() const {
+    return {
+        fetches_.load(std::memory_order_relaxed),
+        misses_.load(std::memory_order_relaxed),
+        bytes_.load(std::memory_order_relaxed),
+        nanos_.load(std::memory_order_relaxed),
+    };
+}
+
 }
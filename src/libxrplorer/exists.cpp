@@ -0,0 +1,330 @@
+#include <xrplorer/exists.hpp>
+#include <xrplorer/context.hpp>
+#include <xrplorer/walk.hpp>
+
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <nudb/xxhasher.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <numeric>
+#include <string_view>
+#include <thread>
+
+namespace xrplorer {
+
+// See `nudb/detail/format.hpp` and `nudb/detail/bucket.hpp`.
+// Integers are big-endian.
+//
+//     header: type "nudb.key" (8), version (2), uid (8), appnum (8),
+//         key size (2), salt (8), pepper (8), block size (2),
+//         load factor (2), reserved (56)
+//     bucket i, at block i + 1: count (2), spill (6),
+//         entries sorted by hash: offset (6), size (6), hash (6)
+//
+// A spill is the offset in the data file of a spill record,
+// which holds the overflow of a full bucket.
+constexpr std::string_view KEY_TYPE{"nudb.key"};
+constexpr std::size_t NBYTES_KEY_HEADER = 104;
+constexpr std::size_t NBYTES_BUCKET_HEADER = 8;
+constexpr std::size_t NBYTES_ENTRY = 18;
+constexpr std::size_t NBYTES_SPILL_HEADER = 8;
+
+static std::uint64_t readBigEndian(std::uint8_t const* data, std::size_t size) {
+    std::uint64_t value = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+        value = (value << 8) | data[i];
+    }
+    return value;
+}
+
+/** Mix the bits of a hash, to derive independent probes. SplitMix64. */
+static std::uint64_t mix(std::uint64_t x) {
+    x += 0x9E3779B97F4A7C15;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EB;
+    return x ^ (x >> 31);
+}
+
+BloomFilter::BloomFilter(std::uint64_t expected, double bitsPerKey)
+    : words_((std::max<std::uint64_t>(expected * bitsPerKey, 64) + 63) / 64)
+    , nbits_(words_.size() * 64)
+    , nhashes_(std::clamp(static_cast<unsigned int>(std::lround(bitsPerKey * 0.69)), 1u, 16u))
+{
+}
+
+void BloomFilter::insert(std::uint64_t hash) {
+    // Double hashing: probe i is `a + i * b`.
+    auto a = mix(hash);
+    auto b = mix(a) | 1;
+    for (auto i = 0u; i < nhashes_; ++i) {
+        auto bit = (a + i * b) % nbits_;
+        words_[bit / 64].fetch_or(std::uint64_t{1} << (bit % 64), std::memory_order_relaxed);
+    }
+}
+
+bool BloomFilter::mayContain(std::uint64_t hash) const {
+    auto a = mix(hash);
+    auto b = mix(a) | 1;
+    for (auto i = 0u; i < nhashes_; ++i) {
+        auto bit = (a + i * b) % nbits_;
+        if (!(words_[bit / 64].load(std::memory_order_relaxed) & (std::uint64_t{1} << (bit % 64)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+struct KeyIndex::Impl {
+    boost::iostreams::mapped_file_source keyFile;
+    boost::iostreams::mapped_file_source datFile;
+    std::uint8_t const* keys = nullptr;
+    std::uint8_t const* dat = nullptr;
+    std::size_t keySize = 0;
+    std::uint64_t salt = 0;
+    std::size_t blockSize = 0;
+    std::uint16_t loadFactor = 0;
+    std::uint64_t nbuckets = 0;
+    std::uint64_t modulus = 0;
+    unsigned int workers = 1;
+    std::unique_ptr<BloomFilter> filter;
+
+    /**
+     * The 48-bit hash that both selects the bucket and is kept in it.
+     * Mirrors `nudb::detail::hash`, which applies `make_hash` to the hasher.
+     */
+    std::uint64_t hash(ripple::uint256 const& digest) const {
+        nudb::xxhasher hasher{salt};
+        return (hasher(digest.data(), keySize) >> 16) & 0xFFFFFFFFFFFF;
+    }
+
+    /** Mirrors `nudb::detail::bucket_index`. */
+    std::uint64_t bucketIndex(std::uint64_t h) const {
+        auto n = h % modulus;
+        if (n >= nbuckets) {
+            n -= modulus / 2;
+        }
+        return n;
+    }
+
+    std::uint8_t const* bucket(std::uint64_t index) const {
+        return keys + (index + 1) * blockSize;
+    }
+
+    /**
+     * Call `visit(hash)` for every entry of a bucket and its spills.
+     * A count that would run past the bucket is cut short at its end.
+     */
+    template <typename Visitor>
+    void forEachEntry(std::uint8_t const* bucket, ExistsStats* stats, Visitor&& visit) const {
+        std::uint64_t size = blockSize;
+        while (bucket) {
+            auto count = std::min(
+                readBigEndian(bucket, 2), (size - NBYTES_BUCKET_HEADER) / NBYTES_ENTRY);
+            auto spill = readBigEndian(bucket + 2, 6);
+            auto const* entry = bucket + NBYTES_BUCKET_HEADER;
+            for (std::uint64_t i = 0; i < count; ++i, entry += NBYTES_ENTRY) {
+                if (!visit(readBigEndian(entry + 12, 6))) {
+                    return;
+                }
+            }
+            bucket = nullptr;
+            auto start = spill + NBYTES_SPILL_HEADER;
+            if (spill != 0 && start + NBYTES_BUCKET_HEADER <= datFile.size()) {
+                // The spill record gives the size of its bucket.
+                size = std::min<std::uint64_t>(
+                    readBigEndian(dat + spill + 6, 2), datFile.size() - start);
+                if (size < NBYTES_BUCKET_HEADER) {
+                    return;
+                }
+                bucket = dat + start;
+                if (stats) {
+                    ++stats->spills;
+                }
+            }
+        }
+    }
+};
+
+KeyIndex::KeyIndex(std::filesystem::path const& directory, unsigned int workers)
+    : impl_(std::make_unique<Impl>())
+{
+    impl_->workers = std::max(workers, 1u);
+    auto keyPath = directory / "nudb.key";
+    auto datPath = directory / "nudb.dat";
+    try {
+        impl_->keyFile.open(keyPath.string());
+        impl_->datFile.open(datPath.string());
+    } catch (std::exception const& ex) {
+        throw Exception{DOES_NOT_EXIST, keyPath, ex.what()};
+    }
+    auto& impl = *impl_;
+    impl.keys = reinterpret_cast<std::uint8_t const*>(impl.keyFile.data());
+    impl.dat = reinterpret_cast<std::uint8_t const*>(impl.datFile.data());
+    if (impl.keyFile.size() < NBYTES_KEY_HEADER
+        || std::memcmp(impl.keys, KEY_TYPE.data(), KEY_TYPE.size()) != 0)
+    {
+        throw Exception{TYPE_UNKNOWN, keyPath, "not a NuDB key file"};
+    }
+    impl.keySize = readBigEndian(impl.keys + 26, 2);
+    impl.salt = readBigEndian(impl.keys + 28, 8);
+    impl.blockSize = readBigEndian(impl.keys + 44, 2);
+    impl.loadFactor = readBigEndian(impl.keys + 46, 2);
+    if (impl.keySize != ripple::uint256::bytes || impl.blockSize < NBYTES_BUCKET_HEADER
+        || impl.keyFile.size() < 2 * impl.blockSize)
+    {
+        throw Exception{TYPE_UNKNOWN, keyPath, "unexpected key file geometry"};
+    }
+    impl.nbuckets = (impl.keyFile.size() - impl.blockSize) / impl.blockSize;
+    impl.modulus = std::bit_ceil(impl.nbuckets);
+}
+
+KeyIndex::~KeyIndex() = default;
+
+void KeyIndex::buildFilter(std::optional<unsigned int> workers) {
+    auto& impl = *impl_;
+    // Buckets are kept about `loadFactor / 65536` full.
+    auto capacity = (impl.blockSize - NBYTES_BUCKET_HEADER) / NBYTES_ENTRY;
+    auto expected = impl.nbuckets * capacity * std::max<std::uint16_t>(impl.loadFactor, 1) / 65536;
+    auto filter = std::make_unique<BloomFilter>(std::max<std::uint64_t>(expected, 1));
+
+    auto nworkers = static_cast<unsigned int>(std::clamp<std::uint64_t>(
+        workers.value_or(impl.workers), 1, impl.nbuckets));
+    auto chunk = (impl.nbuckets + nworkers - 1) / nworkers;
+    std::vector<std::thread> threads;
+    threads.reserve(nworkers);
+    for (auto w = 0u; w < nworkers; ++w) {
+        threads.emplace_back([&, w]() {
+            auto end = std::min(impl.nbuckets, (w + 1) * chunk);
+            for (auto i = w * chunk; i < end; ++i) {
+                impl.forEachEntry(impl.bucket(i), nullptr, [&](std::uint64_t h) {
+                    filter->insert(h);
+                    return true;
+                });
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    impl.filter = std::move(filter);
+}
+
+bool KeyIndex::hasFilter() const {
+    return !!impl_->filter;
+}
+
+std::size_t KeyIndex::filterBytes() const {
+    return impl_->filter ? impl_->filter->bytes() : 0;
+}
+
+std::vector<bool> KeyIndex::contains(
+    std::vector<ripple::uint256> const& digests,
+    ExistsStats& stats,
+    std::optional<unsigned int> workers) const
+{
+    auto const& impl = *impl_;
+    struct Query {
+        std::uint64_t bucket;
+        std::uint64_t hash;
+        std::size_t index;
+    };
+    std::vector<Query> queries;
+    queries.reserve(digests.size());
+    stats.queries += digests.size();
+    for (std::size_t i = 0; i < digests.size(); ++i) {
+        auto h = impl.hash(digests[i]);
+        if (impl.filter && !impl.filter->mayContain(h)) {
+            ++stats.filtered;
+            continue;
+        }
+        queries.push_back({impl.bucketIndex(h), h, i});
+    }
+    std::sort(queries.begin(), queries.end(), [](auto const& a, auto const& b) {
+        return a.bucket < b.bucket;
+    });
+
+    // Split at bucket boundaries, so that no bucket is read twice,
+    // with no more workers than queries.
+    auto nworkers = static_cast<unsigned int>(std::clamp<std::uint64_t>(
+        workers.value_or(impl.workers), 1, std::max<std::size_t>(queries.size(), 1)));
+    std::vector<std::size_t> bounds{0};
+    for (auto w = 1u; w < nworkers; ++w) {
+        auto at = std::max(bounds.back(), queries.size() * w / nworkers);
+        while (at > 0 && at < queries.size() && queries[at].bucket == queries[at - 1].bucket) {
+            ++at;
+        }
+        bounds.push_back(at);
+    }
+    bounds.push_back(queries.size());
+
+    // `std::vector<bool>` packs bits, so workers write bytes instead.
+    std::vector<std::uint8_t> found(digests.size(), 0);
+    std::vector<ExistsStats> partials(nworkers);
+    auto work = [&](unsigned int w) {
+        auto& partial = partials[w];
+        for (auto i = bounds[w]; i < bounds[w + 1];) {
+            auto bucket = queries[i].bucket;
+            auto end = i;
+            while (end < bounds[w + 1] && queries[end].bucket == bucket) {
+                ++end;
+            }
+            ++partial.buckets;
+            // Few queries share a bucket, so test each against every entry.
+            impl.forEachEntry(impl.bucket(bucket), &partial, [&](std::uint64_t h) {
+                for (auto j = i; j < end; ++j) {
+                    if (queries[j].hash == h) {
+                        found[queries[j].index] = 1;
+                    }
+                }
+                return true;
+            });
+            i = end;
+        }
+    };
+    // A single worker runs on the calling thread.
+    if (nworkers == 1) {
+        work(0);
+    } else {
+        std::vector<std::thread> threads;
+        threads.reserve(nworkers);
+        for (auto w = 0u; w < nworkers; ++w) {
+            threads.emplace_back(work, w);
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    for (auto const& partial : partials) {
+        stats.buckets += partial.buckets;
+        stats.spills += partial.spills;
+    }
+    std::vector<bool> result(digests.size());
+    for (std::size_t i = 0; i < digests.size(); ++i) {
+        result[i] = found[i];
+        stats.present += found[i];
+    }
+    return result;
+}
+
+std::shared_ptr<KeyIndex const> openKeyIndex(
+    Database& db, std::filesystem::path const& directory, bool filter)
+{
+    std::lock_guard lock{db.keyIndexMutex_};
+    if (!db.keyIndex_ || (filter && !db.keyIndex_->hasFilter())) {
+        // Replace the index instead of changing it under concurrent readers.
+        auto index = std::make_shared<KeyIndex>(directory, countWalkers(db));
+        if (filter) {
+            index->buildFilter();
+        }
+        db.keyIndex_ = std::move(index);
+    }
+    return db.keyIndex_;
+}
+
+}
@@ -0,0 +1,245 @@
+#include <xrplorer/extract.hpp>
+#include <xrplorer/ledger.hpp>
+#include <xrplorer/object.hpp>
+#include <xrplorer/shamap.hpp>
+#include <xrplorer/shims.hpp>
+#include <xrplorer/walk.hpp>
+
+#include <boost/endian/conversion.hpp>
+#include <fmt/core.h>
+#include <xrpl/protocol/LedgerHeader.h>
+#include <xrpl/protocol/SField.h>
+#include <xrpl/protocol/Serializer.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace xrplorer {
+
+constexpr std::string_view MAGIC{"XRPLTXNS"};
+constexpr std::uint32_t VERSION = 1;
+
+template <typename T>
+static void put(std::string& buffer, T value) {
+    boost::endian::native_to_little_inplace(value);
+    buffer.append(reinterpret_cast<char const*>(&value), sizeof(T));
+}
+
+std::optional<std::uint32_t> peekTransactionIndex(ripple::Slice const& meta) {
+    // Field header 0x20 0x1C is type STI_UINT32 (2), field 28 (sfTransactionIndex).
+    if (meta.size() < 6 || meta[0] != 0x20 || meta[1] != 0x1C) {
+        return std::nullopt;
+    }
+    return (std::uint32_t{meta[2]} << 24) | (meta[3] << 16) | (meta[4] << 8) | meta[5];
+}
+
+struct Item {
+    std::uint32_t index;
+    NodePtr object;
+};
+
+/** Collect the leaves of a transaction tree, in the order of application. */
+static std::vector<Item> readTransactions(Database& db, ripple::uint256 const& root) {
+    std::vector<Item> items;
+    if (root == beast::zero) {
+        return items;
+    }
+    std::vector<ripple::uint256> stack{root};
+    while (!stack.empty()) {
+        auto digest = stack.back();
+        stack.pop_back();
+        auto object = db.fetch(digest);
+        if (!object) {
+            throw Exception{NODE_MISSING, fmt::format("/nodes/{}", digest), "node missing"};
+        }
+        auto leaf = splitLeaf(object);
+        if (!leaf) {
+            auto digests = children(object);
+            stack.insert(stack.end(), digests.begin(), digests.end());
+            continue;
+        }
+        ripple::SerialIter sit{leaf->data};
+        sit.getSlice(sit.getVLDataLength());
+        auto meta = sit.getSlice(sit.getVLDataLength());
+        auto index = peekTransactionIndex(meta);
+        if (!index) {
+            ripple::SerialIter sitMeta{meta};
+            index = ripple::STObject{sitMeta, ripple::sfMetadata}
+                .getFieldU32(ripple::sfTransactionIndex);
+        }
+        items.push_back({*index, std::move(object)});
+    }
+    std::sort(items.begin(), items.end(), [](auto const& a, auto const& b) {
+        return a.index < b.index;
+    });
+    return items;
+}
+
+static void encodeBinary(std::string& buffer, std::uint32_t seq, Item const& item) {
+    auto leaf = splitLeaf(item.object);
+    ripple::SerialIter sit{leaf->data};
+    auto tx = sit.getSlice(sit.getVLDataLength());
+    auto meta = sit.getSlice(sit.getVLDataLength());
+    put<std::uint32_t>(buffer, seq);
+    put<std::uint32_t>(buffer, item.index);
+    buffer.append(reinterpret_cast<char const*>(leaf->key.data()), leaf->key.size());
+    put<std::uint32_t>(buffer, tx.size());
+    buffer.append(reinterpret_cast<char const*>(tx.data()), tx.size());
+    put<std::uint32_t>(buffer, meta.size());
+    buffer.append(reinterpret_cast<char const*>(meta.data()), meta.size());
+}
+
+static void encodeJson(std::string& buffer, std::uint32_t seq, Item const& item) {
+    auto transaction = decodeTransaction(item.object);
+    Json::Value value{Json::objectValue};
+    value["ledger_index"] = seq;
+    value["hash"] = to_string(splitLeaf(item.object)->key);
+    value["tx"] = transaction.tx->getJson(ripple::JsonOptions::none);
+    value["meta"] = transaction.meta->getJson(ripple::JsonOptions::none);
+    Json::stream(value, [&buffer](auto const& chunk) {
+        buffer.append(chunk.data(), chunk.size());
+    });
+    buffer.push_back('\n');
+}
+
+/** One encoded ledger, waiting in the reorder buffer. */
+struct Slot {
+    bool ready = false;
+    std::string bytes;
+    std::uint64_t transactions = 0;
+};
+
+ExtractStats extractTransactions(
+    Database& db,
+    NodePtr const& anchor,
+    std::uint32_t from,
+    std::uint32_t to,
+    FILE* out,
+    StreamFormat format,
+    std::optional<unsigned int> workers,
+    std::optional<unsigned int> window)
+{
+    // Each worker finds its own ledger through the skip lists of the newest,
+    // so none waits for the chain to be read.
+    auto top = findLedger(db, anchor, to);
+    if (!top) {
+        throw Exception{NODE_MISSING, fmt::format("ledger {}", to), "ledger missing"};
+    }
+
+    auto nworkers = countWalkers(db, workers);
+    auto nslots = std::max(window.value_or(2 * nworkers), 1u);
+    auto const nledgers = (from <= to) ? std::size_t{to} - from + 1 : 0;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<Slot> slots(nslots);
+    std::size_t claimed = 0;
+    std::size_t written = 0;
+    std::exception_ptr error;
+
+    auto work = [&]() {
+        std::unique_lock lock{mutex};
+        while (true) {
+            cv.wait(lock, [&]() {
+                return error || claimed >= nledgers || claimed < written + nslots;
+            });
+            if (error || claimed >= nledgers) {
+                return;
+            }
+            auto i = claimed++;
+            lock.unlock();
+
+            Slot slot;
+            try {
+                auto seq = static_cast<std::uint32_t>(from + i);
+                auto header = findLedger(db, top, seq);
+                if (!header) {
+                    throw Exception{
+                        NODE_MISSING, fmt::format("ledger {}", seq), "ledger missing"};
+                }
+                auto info = ripple::deserializePrefixedHeader(header);
+                auto items = readTransactions(db, info.txHash);
+                for (auto const& item : items) {
+                    if (format == StreamFormat::NDJSON) {
+                        encodeJson(slot.bytes, info.seq, item);
+                    } else {
+                        encodeBinary(slot.bytes, info.seq, item);
+                    }
+                }
+                slot.transactions = items.size();
+                slot.ready = true;
+            } catch (...) {
+                lock.lock();
+                error = std::current_exception();
+                cv.notify_all();
+                return;
+            }
+
+            lock.lock();
+            slots[i % nslots] = std::move(slot);
+            cv.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(nworkers);
+    for (auto i = 0u; i < nworkers; ++i) {
+        threads.emplace_back(work);
+    }
+
+    ExtractStats stats;
+    auto write = [&](std::string_view bytes) {
+        if (std::fwrite(bytes.data(), 1, bytes.size(), out) != bytes.size()) {
+            throw Exception{WRITE_FAILED, "", "write failed"};
+        }
+        stats.bytes += bytes.size();
+    };
+    try {
+        if (format == StreamFormat::BINARY) {
+            std::string header{MAGIC};
+            put<std::uint32_t>(header, VERSION);
+            put<std::uint32_t>(header, 0);
+            write(header);
+        }
+        // The calling thread drains the reorder buffer in ledger order.
+        std::unique_lock lock{mutex};
+        while (written < nledgers) {
+            auto& next = slots[written % nslots];
+            cv.wait(lock, [&]() { return error || next.ready; });
+            if (error) {
+                break;
+            }
+            auto slot = std::move(next);
+            next = Slot{};
+            ++written;
+            cv.notify_all();
+            lock.unlock();
+            write(slot.bytes);
+            ++stats.ledgers;
+            stats.transactions += slot.transactions;
+            lock.lock();
+        }
+    } catch (...) {
+        std::lock_guard lock{mutex};
+        if (!error) {
+            error = std::current_exception();
+        }
+        cv.notify_all();
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    std::fflush(out);
+    return stats;
+}
+
+}
@@ -1,5 +1,11 @@
 #include <xrplorer/filesystem.hpp>
+#include <xrplorer/book.hpp>
+#include <xrplorer/materialize.hpp>
+#include <xrplorer/select.hpp>
+#include <xrplorer/shamap.hpp>
+#include <xrplorer/shims.hpp>
 #include <xrplorer/tlpush.hpp>
+#include <xrplorer/walk.hpp>
 
 #include <fmt/core.h>
 #include <spdlog/spdlog.h>
@@ -15,112 +21,15 @@
 #include <xrpl/protocol/STTx.h>
 #include <xrpl/protocol/TxMeta.h>
 
+#include <algorithm>
+#include <cassert>
 #include <cstdint>
+#include <fnmatch.h>
+#include <iterator>
 #include <memory>
+#include <optional>
 #include <type_traits>
 
-// TODO: Move these shims to their own TU.
-namespace ripple {
-using NodePtr = std::shared_ptr<NodeObject>;
-using SLE = STLedgerEntry;
-template <std::size_t Bits, class Tag>
-auto format_as(base_uint<Bits, Tag> const& uint) {
-    return to_string(uint);
-}
-auto format_as(NodeObjectType const& type) {
-    return to_string(type);
-}
-auto format_as(LedgerEntryType type) {
-    return fmt::format("0x{:04X}", std::underlying_type_t<LedgerEntryType>(type));
-}
-auto format_as(HashPrefix prefix) {
-    // Prefix is 3 ASCII characters packed into a std::uint32_t.
-    std::uint32_t i = static_cast<std::underlying_type_t<HashPrefix>>(prefix);
-    char a = (i >> 24) & 0xFF;
-    char b = (i >> 16) & 0xFF;
-    char c = (i >>  8) & 0xFF;
-    return fmt::format("0x{:X} ({}{}{})", i, a, b, c);
-}
-HashPrefix deserializePrefix(NodePtr const& object) {
-    // TODO: Shouldn't Slice have an implicit constructor from vector of bytes?
-    auto const& slice = makeSlice(object->getData());
-    SerialIter sit{slice};
-    auto prefix = safe_cast<HashPrefix>(sit.get32());
-    return prefix;
-}
-LedgerHeader deserializePrefixedHeader(NodePtr const& object) {
-    auto const& slice = makeSlice(object->getData());
-    return deserializePrefixedHeader(slice);
-}
-struct SHAMapInnerNode {
-    static constexpr unsigned int branchFactor = 16;
-};
-unsigned int selectBranch(uint256 const& key, unsigned int depth) {
-    auto branch = static_cast<unsigned int>(*(key.begin() + (depth / 2)));
-    if (depth & 1)
-        branch &= 0xf;
-    else
-        branch >>= 4;
-    assert(branch < SHAMapInnerNode::branchFactor);
-    return branch;
-}
-SLE make_sle(NodePtr const& object) {
-    auto slice = makeSlice(object->getData());
-    slice.remove_prefix(4);
-    Serializer serializer{slice.data(), slice.size()};
-    uint256 key;
-    bool success = serializer.getBitString(key, serializer.size() - key.bytes);
-    assert(success);
-    serializer.chop(key.bytes);
-    auto slice2 = serializer.slice();
-    SerialIter sit{slice2};
-    return SLE{sit, key};
-}
-SLE make_sle(Keylet const& keylet, NodePtr const& object) {
-    // A `Slice` is passed to `SHAMapTreeNode::makeFromPrefix`
-    // which removes the 4 byte prefix.
-    auto slice = makeSlice(object->getData());
-    slice.remove_prefix(4);
-    // It passes the remaining slice to `SHAMapTreeNode::makeAccountState`
-    // which constructs a `Serializer`
-    // (which calls itself the replacement for now-deprecated `SerialIter`)
-    // and removes the 32 byte suffix.
-    // (That suffix should match the keylet key, by the way).
-    Serializer serializer{slice.data(), slice.size()};
-    serializer.chop(32);
-    // Then it constructs a _new_ `Slice` from the `Serializer`
-    // and passes it to `make_shamapitem`,
-    // which `memcpy`s the bytes into a `SHAMapItem`.
-    // I don't know where an `STObject` is ever constructed by `SHAMap`,
-    // but that final slice is the one it is expecting.
-    auto slice2 = serializer.slice();
-    // An `STLedgerEntry` cannot be constructed
-    // with a `Slice` or a `Serializer`, though. Only a `SerialIter`.
-    SerialIter sit{slice2};
-    return SLE{sit, keylet.key};
-}
-STObject make_txm(NodePtr const& object) {
-    auto slice = makeSlice(object->getData());
-    slice.remove_prefix(4);
-    Serializer serializer{slice.data(), slice.size()};
-    uint256 key;
-    bool success = serializer.getBitString(key, serializer.size() - key.bytes);
-    assert(success);
-    serializer.chop(key.bytes);
-    auto slice2 = serializer.slice();
-    SerialIter sit2{slice2};
-    auto lengthTx = sit2.getVLDataLength();
-    auto sliceTx = sit2.getSlice(lengthTx);
-    SerialIter sitTx{sliceTx};
-    STObject stTx{sitTx, sfTransaction};
-    auto lengthMeta = sit2.getVLDataLength();
-    auto sliceMeta = sit2.getSlice(lengthMeta);
-    SerialIter sitMeta{sliceMeta};
-    STObject stMeta{sitMeta, sfMetadata};
-    return stTx;
-}
-}
-
 namespace xrplorer {
 
 using SLE = ripple::SLE;
@@ -141,7 +50,7 @@ struct NodesDirectory : public Directory<NodesDirectory> {
 };
 
 static void nodeBranch(Context& ctx, ripple::uint256 const& digest) {
-    auto object = ctx.os.db()->fetchNodeObject(digest);
+    auto object = ctx.os.db().fetch(digest);
     if (!object) {
         throw ctx.throw_(NODE_MISSING, "node missing");
     }
@@ -182,26 +91,121 @@ struct HeaderDirectory : public SpecialDirectory<HeaderDirectory, const NodePtr>
         }
         throw ctx.notExists();
     }
+    static Json::Value json(Context& ctx, value_type const& object) {
+        auto header{ripple::deserializePrefixedHeader(object)};
+        Json::Value value{Json::objectValue};
+        value["ledger_index"] = header.seq;
+        value["parent_hash"] = to_string(header.parentHash);
+        value["transaction_hash"] = to_string(header.txHash);
+        value["account_hash"] = to_string(header.accountHash);
+        value["total_coins"] = to_string(header.drops);
+        value["close_time"] = header.closeTime.time_since_epoch().count();
+        value["parent_close_time"] = header.parentCloseTime.time_since_epoch().count();
+        return value;
+    }
+    static void resolve(Context& ctx, value_type const& object) {
+        ctx.found.node = object;
+        ctx.found.object = ripple::deserializePrefixedHeader(object);
+    }
 };
 
 struct StateDirectory : public SpecialDirectory<StateDirectory, const ripple::uint256> {
     static std::vector<std::string> list(Context& ctx, value_type const& digest) {
-        return {"accounts", fmt::format("root -> /nodes/{}", digest)};
+        return {"accounts", "books", "keys", fmt::format("root -> /nodes/{}", digest)};
     }
     static void open(Context& ctx, value_type const& digest, fs::path const& name) {
         if (name == "root") {
             return nodeBranch(ctx, digest);
         }
         if (name == "accounts") {
-            auto root = ctx.os.db()->fetchNodeObject(digest);
+            auto root = ctx.os.db().fetch(digest);
             if (!root) {
                 throw ctx.notExists();
             }
             tlpush _root{ctx.root, std::move(root)};
             return AccountsDirectory::call(ctx);
         }
+        if (name == "books") {
+            auto root = ctx.os.db().fetch(digest);
+            if (!root) {
+                throw ctx.notExists();
+            }
+            tlpush _root{ctx.root, std::move(root)};
+            return BooksDirectory::call(ctx);
+        }
+        if (name == "keys") {
+            auto root = ctx.os.db().fetch(digest);
+            if (!root) {
+                throw ctx.notExists();
+            }
+            tlpush _root{ctx.root, std::move(root)};
+            return KeysDirectory::call(ctx, KeyQuery{});
+        }
         throw ctx.notImplemented();
     }
+    static void resolve(Context& ctx, value_type const& digest) {
+        ctx.found.node = ctx.os.db().fetch(digest);
+        if (!ctx.found.node) {
+            throw ctx.throw_(NODE_MISSING, "node missing");
+        }
+        if (auto inner = decodeInner(ctx.found.node)) {
+            ctx.found.object = std::move(*inner);
+        }
+    }
+};
+
+struct KeyQuery {
+    KeyRange range;
+    std::optional<ripple::LedgerEntryType> type;
+};
+
+// A directory of the leaves under the nearest SHAMap root,
+// narrowed by each path component,
+// which is either a key range (see `KeyRange::parse`)
+// or a `LedgerEntryType` name (e.g. `Offer`).
+// A full key opens the leaf.
+struct KeysDirectory : public SpecialDirectory<KeysDirectory, const KeyQuery> {
+    static std::vector<std::string> list(Context& ctx, value_type const& query) {
+        std::vector<std::string> names;
+        visitLeaves(ctx.os.db(), ctx.root, query.range, query.type, [&](Leaf const& leaf) {
+            names.push_back(to_string(leaf.key));
+            return true;
+        });
+        return names;
+    }
+    static void open(Context& ctx, value_type const& query, fs::path const& path) {
+        auto name = path.generic_string();
+        if (name.size() == 2 * ripple::uint256::bytes) {
+            ripple::uint256 key;
+            if (!key.parseHex(name) || !query.range.contains(key)) {
+                throw ctx.notExists();
+            }
+            auto object = findLeaf(ctx.os.db(), ctx.root, key);
+            if (!object) {
+                throw ctx.notExists();
+            }
+            auto leaf = splitLeaf(object);
+            if (query.type && peekType(leaf->data) != query.type) {
+                throw ctx.notExists();
+            }
+            return SleDirectory::call(ctx, leaf->sle());
+        }
+        if (auto type = parseType(name)) {
+            return KeysDirectory::call(ctx, KeyQuery{query.range, type});
+        }
+        if (auto range = KeyRange::parse(name)) {
+            return KeysDirectory::call(ctx, KeyQuery{intersect(query.range, *range), query.type});
+        }
+        throw ctx.notExists();
+    }
+    static void resolve(Context& ctx, value_type const& query) {
+        std::vector<ripple::uint256> keys;
+        visitLeaves(ctx.os.db(), ctx.root, query.range, query.type, [&](Leaf const& leaf) {
+            keys.push_back(leaf.key);
+            return true;
+        });
+        ctx.found.object = std::move(keys);
+    }
 };
 
 struct InnerDirectory : public SpecialDirectory<InnerDirectory, const NodePtr> {
@@ -247,12 +251,88 @@ struct InnerDirectory : public SpecialDirectory<InnerDirectory, const NodePtr> {
         auto childDigest = sit.get256();
         return nodeBranch(ctx, childDigest);
     }
+    static Json::Value json(Context& ctx, value_type const& object) {
+        auto const& slice = ripple::makeSlice(object->getData());
+        ripple::SerialIter sit(slice.data(), slice.size());
+        // Consume the prefix.
+        sit.get32();
+        Json::Value children{Json::objectValue};
+        for (auto i = 0; i < ripple::SHAMapInnerNode::branchFactor; ++i) {
+            auto childDigest = sit.get256();
+            if (childDigest == beast::zero)
+            {
+                continue;
+            }
+            children[fmt::format("{:X}", i)] = to_string(childDigest);
+        }
+        return children;
+    }
+    static void resolve(Context& ctx, value_type const& object) {
+        ctx.found.node = object;
+        ctx.found.object = *decodeInner(object);
+    }
 };
 
 struct AccountsDirectory : public Directory<AccountsDirectory> {
     static std::vector<std::string> list(Context& ctx) {
         return {"<base58 address, e.g. rHb9CJAWyB4rj91VRWn96DkukG4bwdtyTh>"};
     }
+    // Scan the state tree with every walker,
+    // reading each address from the serialized account root,
+    // and keep only the names that match the glob.
+    // Each match is loaded again when its branch opens it.
+    static void _expand(Context& ctx, void* spl) {
+        auto const& pattern = ctx.it->native();
+        auto match = [&](Leaf const& leaf, std::vector<std::string>& names) {
+            auto name = accountName(leaf);
+            if (::fnmatch(pattern.c_str(), name.c_str(), FNM_PERIOD) == 0) {
+                names.push_back(std::move(name));
+            }
+        };
+        auto& db = ctx.os.db();
+        std::vector<std::vector<std::string>> parts(countWalkers(db));
+        if (materialized(db, ctx.root->getHash())) {
+            visitLeaves(db, ctx.root, KeyRange{}, ripple::ltACCOUNT_ROOT,
+                [&](Leaf const& leaf) {
+                    match(leaf, parts[0]);
+                    return true;
+                });
+        } else {
+            walk(db, {ctx.root->getHash()},
+                [&](unsigned int worker, ripple::uint256 const& digest, NodePtr const& object, unsigned int) {
+                    if (!object) {
+                        throw Exception{
+                            NODE_MISSING, fmt::format("/nodes/{}", digest), "node missing"};
+                    }
+                    auto leaf = splitLeaf(object);
+                    if (!leaf) {
+                        return true;
+                    }
+                    if (peekType(leaf->data) == ripple::ltACCOUNT_ROOT) {
+                        match(*leaf, parts[worker]);
+                    }
+                    return false;
+                });
+        }
+        std::vector<std::string> names;
+        for (auto& part : parts) {
+            names.insert(names.end(),
+                std::make_move_iterator(part.begin()), std::make_move_iterator(part.end()));
+        }
+        std::sort(names.begin(), names.end());
+        return ctx.expand(
+            [&]() { return names; },
+            [&](Context& branch, fs::path const& name) {
+                return AccountsDirectory::open(branch, name);
+            });
+    }
+    static std::string accountName(Leaf const& leaf) {
+        auto value = findField(leaf.data, ripple::sfAccount);
+        if (value && value->size() == ripple::AccountID::bytes) {
+            return ripple::toBase58(ripple::AccountID::fromVoid(value->data()));
+        }
+        return ripple::toBase58(leaf.sle().getAccountID(ripple::sfAccount));
+    }
     static void open(Context& ctx, fs::path const& b58AccountId) {
         auto optAccountId = ripple::parseBase58<ripple::AccountID>(b58AccountId);
         if (!optAccountId) {
@@ -268,34 +348,94 @@ struct AccountsDirectory : public Directory<AccountsDirectory> {
     }
 };
 
-static constexpr unsigned int NBYTES_DIGEST = 256 / 8;
-
-static NodePtr load(Context& ctx, ripple::Keylet const& keylet) {
-    assert(ctx.root);
-    NodePtr object{ctx.root};
-    // One-past-end depth is 256 / 4 = 64.
-    for (auto depth = 0; depth < 64; ++depth) {
-        auto const& slice = ripple::makeSlice(object->getData());
-        ripple::SerialIter sit{slice.data(), slice.size()};
-        auto prefix = ripple::safe_cast<ripple::HashPrefix>(sit.get32());
-        if (prefix == ripple::HashPrefix::leafNode) {
-            break;
+// Order books by the issue that takers pay, then the issue that they get.
+struct BooksDirectory : public Directory<BooksDirectory> {
+    static std::vector<std::string> list(Context& ctx) {
+        return {"<issue, e.g. XRP or USD.rhub8VRN55s94qWKDv6jmDy1pUykJzF3wq>"};
+    }
+    static void open(Context& ctx, fs::path const& name) {
+        auto pays = parseIssue(name.generic_string());
+        if (!pays) {
+            throw ctx.notExists();
         }
-        if (prefix != ripple::HashPrefix::innerNode) {
-            return {};
+        return BookSideDirectory::call(ctx, *pays);
+    }
+};
+
+struct BookSideDirectory : public SpecialDirectory<BookSideDirectory, const ripple::Issue> {
+    static std::vector<std::string> list(Context& ctx, value_type const& pays) {
+        return BooksDirectory::list(ctx);
+    }
+    static void open(Context& ctx, value_type const& pays, fs::path const& name) {
+        auto gets = parseIssue(name.generic_string());
+        if (!gets || *gets == pays) {
+            throw ctx.notExists();
         }
-        auto childIndex = ripple::selectBranch(keylet.key, depth);
-        sit.skip(NBYTES_DIGEST * childIndex);
-        auto childDigest = sit.get256();
-        if (childDigest == beast::zero) {
-            return {};
+        return BookDirectory::call(ctx, ripple::Book{pays, *gets});
+    }
+};
+
+// The offers in a book, in the order that they would be taken.
+struct BookDirectory : public SpecialDirectory<BookDirectory, const ripple::Book> {
+    static std::vector<std::string> list(Context& ctx, value_type const& book) {
+        std::vector<std::string> names;
+        visitBook(ctx.os.db(), ctx.root, book, [&](SLE const& offer) {
+            names.push_back(to_string(offer.key()));
+            return true;
+        });
+        return names;
+    }
+    static void open(Context& ctx, value_type const& book, fs::path const& path) {
+        ripple::uint256 key;
+        if (!key.parseHex(path.generic_string())) {
+            throw ctx.notExists();
         }
-        object = ctx.os.db()->fetchNodeObject(childDigest);
+        auto object = findLeaf(ctx.os.db(), ctx.root, key);
         if (!object) {
-            return {};
+            throw ctx.notExists();
         }
+        auto offer = splitLeaf(object)->sle();
+        if (offer.getType() != ripple::ltOFFER
+            || !(offer.getFieldAmount(ripple::sfTakerPays).issue() == book.in)
+            || !(offer.getFieldAmount(ripple::sfTakerGets).issue() == book.out))
+        {
+            throw ctx.notExists();
+        }
+        return SleDirectory::call(ctx, offer);
+    }
+    static std::string stream(Context& ctx, value_type const& book) {
+        std::string text;
+        visitBook(ctx.os.db(), ctx.root, book, [&](SLE const& offer) {
+            text += fmt::format("{} {} {} {}\n",
+                offer.key(),
+                ripple::toBase58(offer.getAccountID(ripple::sfAccount)),
+                offer.getFieldAmount(ripple::sfTakerPays).getText(),
+                offer.getFieldAmount(ripple::sfTakerGets).getText());
+            return true;
+        });
+        return text;
+    }
+    static Json::Value json(Context& ctx, value_type const& book) {
+        Json::Value offers{Json::arrayValue};
+        visitBook(ctx.os.db(), ctx.root, book, [&](SLE const& offer) {
+            offers.append(offer.getJson(ripple::JsonOptions::none));
+            return true;
+        });
+        return offers;
     }
-    return object;
+    static void resolve(Context& ctx, value_type const& book) {
+        std::vector<ripple::uint256> keys;
+        visitBook(ctx.os.db(), ctx.root, book, [&](SLE const& offer) {
+            keys.push_back(offer.key());
+            return true;
+        });
+        ctx.found.object = std::move(keys);
+    }
+};
+
+static NodePtr load(Context& ctx, ripple::Keylet const& keylet) {
+    assert(ctx.root);
+    return findLeaf(ctx.os.db(), ctx.root, keylet.key);
 }
 
 static void sleDirectory(Context& ctx, NodePtr const& object) {
@@ -325,6 +465,12 @@ struct SleDirectory : public SpecialDirectory<SleDirectory, const SLE> {
         }
         throw ctx.notExists();
     }
+    static Json::Value json(Context& ctx, value_type const& sle) {
+        return sle.getJson(ripple::JsonOptions::none);
+    }
+    static void resolve(Context& ctx, value_type const& sle) {
+        ctx.found.object = std::make_shared<SLE const>(sle);
+    }
 };
 
 struct TxmDirectory : public SpecialDirectory<TxmDirectory, const NodePtr> {
@@ -348,12 +494,25 @@ struct TxmDirectory : public SpecialDirectory<TxmDirectory, const NodePtr> {
         }
         throw ctx.notExists();
     }
+    static Json::Value json(Context& ctx, value_type const& object) {
+        return make_txm(object).getJson(ripple::JsonOptions::none);
+    }
+    static void resolve(Context& ctx, value_type const& object) {
+        ctx.found.node = object;
+        ctx.found.object = decodeTransaction(object);
+    }
 };
 
 struct SfieldFile : public SpecialFile<SfieldFile, const ripple::STBase> {
     static std::string stream(Context& ctx, value_type const& sfield) {
         return sfield.getText();
     }
+    static Json::Value json(Context& ctx, value_type const& sfield) {
+        return sfield.getJson(ripple::JsonOptions::none);
+    }
+    static void resolve(Context& ctx, value_type const& sfield) {
+        ctx.found.object = copyField(sfield);
+    }
 };
 
 template <typename T>
@@ -366,6 +525,16 @@ struct ValueFile : public SpecialFile<ValueFile<T>, const T> {
     static std::string stream(Context& ctx, T const& value) {
         return fmt::format("{}", value);
     }
+    static Json::Value json(Context& ctx, T const& value) {
+        if constexpr (std::is_integral_v<T>) {
+            return value;
+        } else {
+            return stream(ctx, value);
+        }
+    }
+    static void resolve(Context& ctx, T const& value) {
+        ctx.found.object = value;
+    }
 };
 
 };
@@ -376,4 +545,21 @@ void RootDirectory::open(Context& ctx, fs::path const& name) {
     }
 }
 
+Resolution command(OperatingSystem& os, std::string_view argument, Action action) {
+    auto path = (os.getcwd() / argument).lexically_normal();
+    auto it = path.begin();
+    assert(*it == "/");
+    ++it;
+    Context ctx {
+        .os = os,
+        .argument = argument,
+        .path = path,
+        .it = std::move(it),
+        .action = action,
+        .out = os.stdout,
+    };
+    RootDirectory::call(ctx);
+    return std::move(ctx.found);
+}
+
 }
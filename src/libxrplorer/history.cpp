@@ -0,0 +1,131 @@
+#include <xrplorer/history.hpp>
+#include <xrplorer/ledger.hpp>
+#include <xrplorer/shamap.hpp>
+#include <xrplorer/shims.hpp>
+
+#include <fmt/core.h>
+
+#include <vector>
+
+namespace xrplorer {
+
+static Exception nodeMissing(ripple::uint256 const& digest) {
+    return Exception{NODE_MISSING, fmt::format("/nodes/{}", digest), "node missing"};
+}
+
+/**
+ * The nodes on the path to a key in one state tree, from the root down.
+ * The last is a leaf, possibly with another key,
+ * unless the path ends at an empty branch.
+ */
+using Path = std::vector<NodePtr>;
+
+/**
+ * Return the path to `key` under the root with digest `root`,
+ * given `other`, the path to `key` in another tree.
+ * Below the first digest that the paths share,
+ * the nodes of `other` are reused instead of fetched,
+ * and `shared` is set.
+ */
+static Path descend(
+    Database& db,
+    ripple::uint256 digest,
+    Path const& other,
+    ripple::uint256 const& key,
+    bool& shared)
+{
+    Path path;
+    shared = false;
+    for (auto depth = 0u; ; ++depth) {
+        if (depth < other.size() && other[depth]->getHash() == digest) {
+            path.insert(path.end(), other.begin() + depth, other.end());
+            shared = true;
+            return path;
+        }
+        if (digest == beast::zero) {
+            return path;
+        }
+        auto object = db.fetch(digest);
+        if (!object) {
+            throw nodeMissing(digest);
+        }
+        path.push_back(object);
+        if (depth == MAX_DEPTH) {
+            return path;
+        }
+        auto child = branchDigest(object, ripple::selectBranch(key, depth));
+        if (!child) {
+            return path;
+        }
+        digest = *child;
+    }
+}
+
+/** Return the leaf at the end of `path` if it has `key`. */
+static NodePtr leafAt(Path const& path, ripple::uint256 const& key) {
+    if (path.empty()) {
+        return {};
+    }
+    auto leaf = splitLeaf(path.back());
+    if (!leaf || leaf->key != key) {
+        return {};
+    }
+    return path.back();
+}
+
+static bool sameLeaf(NodePtr const& a, NodePtr const& b) {
+    if (!a || !b) {
+        return !a && !b;
+    }
+    // The digest of a leaf covers both its key and its item.
+    return a->getHash() == b->getHash();
+}
+
+EntryHistory entryHistory(
+    Database& db,
+    NodePtr const& anchor,
+    ripple::uint256 const& key,
+    std::uint32_t from,
+    std::uint32_t to,
+    ChangeVisitor const& visitor)
+{
+    EntryHistory history;
+    auto object = findLedger(db, anchor, to);
+    if (!object) {
+        throw Exception{NODE_MISSING, fmt::format("ledger {}", to), "ledger missing"};
+    }
+    auto current = ripple::deserializePrefixedHeader(object);
+    bool shared = false;
+    auto path = descend(db, current.accountHash, {}, key, shared);
+    auto leaf = leafAt(path, key);
+    while (current.seq > from) {
+        auto parentObject = db.fetch(current.parentHash);
+        if (!parentObject) {
+            throw nodeMissing(current.parentHash);
+        }
+        auto parent = ripple::deserializePrefixedHeader(parentObject);
+        ++history.ledgers;
+        auto parentPath = descend(db, parent.accountHash, path, key, shared);
+        NodePtr parentLeaf;
+        if (shared) {
+            parentLeaf = leaf;
+            ++history.unchanged;
+        } else {
+            parentLeaf = leafAt(parentPath, key);
+        }
+        if (!sameLeaf(parentLeaf, leaf)) {
+            if (!visitor(EntryChange{current, parentLeaf, leaf})) {
+                break;
+            }
+        }
+        current = parent;
+        path = std::move(parentPath);
+        leaf = std::move(parentLeaf);
+    }
+    if (current.seq <= from) {
+        history.initial = leaf;
+    }
+    return history;
+}
+
+}
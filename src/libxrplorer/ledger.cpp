@@ -0,0 +1,98 @@
+#include <xrplorer/ledger.hpp>
+#include <xrplorer/shamap.hpp>
+#include <xrplorer/shims.hpp>
+
+#include <fmt/core.h>
+#include <xrpl/protocol/Indexes.h>
+#include <xrpl/protocol/SField.h>
+
+namespace xrplorer {
+
+NodePtr readLeaf(
+    Database& db, ripple::LedgerHeader const& header, ripple::uint256 const& key)
+{
+    auto root = db.fetch(header.accountHash);
+    if (!root) {
+        return {};
+    }
+    return findLeaf(db, root, key);
+}
+
+std::optional<ripple::uint256> hashOfSeq(
+    Database& db, ripple::LedgerHeader const& header, std::uint32_t seq)
+{
+    if (seq >= header.seq) {
+        return std::nullopt;
+    }
+    auto diff = header.seq - seq;
+    if (diff <= 256) {
+        // The last 256 ancestors are listed in one entry.
+        if (auto object = readLeaf(db, header, ripple::keylet::skip().key)) {
+            auto sle = splitLeaf(object)->sle();
+            auto const& hashes = sle.getFieldV256(ripple::sfHashes);
+            if (hashes.size() >= diff) {
+                return hashes[hashes.size() - diff];
+            }
+        }
+    }
+    if ((seq & 0xFF) != 0) {
+        return std::nullopt;
+    }
+    // Every 256th ancestor is listed in entries of 65536 ledgers each.
+    if (auto object = readLeaf(db, header, ripple::keylet::skip(seq).key)) {
+        auto sle = splitLeaf(object)->sle();
+        auto lastSeq = sle.getFieldU32(ripple::sfLastLedgerSequence);
+        if (lastSeq < seq) {
+            return std::nullopt;
+        }
+        auto const& hashes = sle.getFieldV256(ripple::sfHashes);
+        auto diff256 = (lastSeq - seq) >> 8;
+        if (hashes.size() > diff256) {
+            return hashes[hashes.size() - diff256 - 1];
+        }
+    }
+    return std::nullopt;
+}
+
+NodePtr findLedger(Database& db, NodePtr const& anchor, std::uint32_t seq) {
+    NodePtr object{anchor};
+    while (object) {
+        auto header = ripple::deserializePrefixedHeader(object);
+        if (header.seq <= seq) {
+            return (header.seq == seq) ? object : nullptr;
+        }
+        // The nearest flag ledger at or after `seq`.
+        auto flag = (seq + 0xFF) & ~std::uint32_t{0xFF};
+        auto digest = hashOfSeq(db, header, seq);
+        if (!digest && flag < header.seq) {
+            digest = hashOfSeq(db, header, flag);
+        }
+        object = db.fetch(digest.value_or(header.parentHash));
+    }
+    return object;
+}
+
+std::vector<ripple::LedgerHeader> collectLedgers(
+    Database& db, NodePtr const& anchor, std::uint32_t from, std::uint32_t to)
+{
+    auto object = findLedger(db, anchor, to);
+    if (!object) {
+        throw Exception{NODE_MISSING, fmt::format("ledger {}", to), "ledger missing"};
+    }
+    std::vector<ripple::LedgerHeader> headers;
+    headers.push_back(ripple::deserializePrefixedHeader(object));
+    headers.back().hash = object->getHash();
+    while (headers.back().seq > from) {
+        auto parentHash = headers.back().parentHash;
+        auto parent = db.fetch(parentHash);
+        if (!parent) {
+            throw Exception{
+                NODE_MISSING, fmt::format("/nodes/{}", parentHash), "node missing"};
+        }
+        headers.push_back(ripple::deserializePrefixedHeader(parent));
+        headers.back().hash = parentHash;
+    }
+    return headers;
+}
+
+}
@@ -0,0 +1,167 @@
+#include <xrplorer/materialize.hpp>
+#include <xrplorer/walk.hpp>
+
+#include <fmt/core.h>
+#include <xrpl/protocol/HashPrefix.h>
+#include <xrpl/protocol/Serializer.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace xrplorer {
+
+NodePtr MaterializedState::object(std::size_t i) const {
+    auto const& item = leaf(i);
+    ripple::Serializer s;
+    s.add32(ripple::HashPrefix::leafNode);
+    s.addRaw(item.data);
+    s.addBitString(item.key);
+    auto digest = s.getSHA512Half();
+    return ripple::NodeObject::createObject(
+        ripple::hotACCOUNT_NODE, ripple::Blob{s.peekData()}, digest);
+}
+
+std::optional<std::size_t> MaterializedState::find(ripple::uint256 const& key) const {
+    auto it = std::lower_bound(keys.begin(), keys.end(), key);
+    if (it == keys.end() || *it != key) {
+        return std::nullopt;
+    }
+    return it - keys.begin();
+}
+
+bool MaterializedState::visit(
+    KeyRange const& range,
+    std::optional<ripple::LedgerEntryType> type,
+    LeafVisitor const& visitor) const
+{
+    if (range.empty()) {
+        return true;
+    }
+    auto i = static_cast<std::size_t>(
+        std::lower_bound(keys.begin(), keys.end(), range.first) - keys.begin());
+    for (; i < keys.size() && !(range.last < keys[i]); ++i) {
+        if (type && types[i] != *type) {
+            continue;
+        }
+        if (!visitor(leaf(i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::size_t MaterializedState::bytes() const {
+    return keys.size() * sizeof(keys[0])
+        + types.size() * sizeof(types[0])
+        + offsets.size() * sizeof(offsets[0])
+        + blob.size();
+}
+
+/** The leaves that one walker found, in the order it found them. */
+struct Part {
+    std::vector<ripple::uint256> keys;
+    std::vector<std::uint16_t> types;
+    std::vector<std::uint64_t> offsets;
+    std::vector<std::uint8_t> blob;
+};
+
+std::shared_ptr<MaterializedState const> materialize(
+    Database& db, ripple::uint256 const& root, std::optional<unsigned int> walkers)
+{
+    std::vector<Part> parts(countWalkers(db, walkers));
+    std::atomic<bool> missing{false};
+    walk(db, {root},
+        [&](unsigned int worker, ripple::uint256 const&, NodePtr const& object, unsigned int) {
+            if (!object) {
+                missing = true;
+                return false;
+            }
+            auto leaf = splitLeaf(object);
+            if (!leaf) {
+                return true;
+            }
+            auto& part = parts[worker];
+            part.keys.push_back(leaf->key);
+            part.types.push_back(peekType(leaf->data).value_or(ripple::LedgerEntryType{}));
+            part.offsets.push_back(part.blob.size());
+            part.blob.insert(part.blob.end(), leaf->data.begin(), leaf->data.end());
+            return false;
+        },
+        walkers);
+    if (missing) {
+        throw Exception{NODE_MISSING, fmt::format("/nodes/{}", root), "tree incomplete"};
+    }
+
+    // Sort references into the parts,
+    // and lay out the entries in key order.
+    struct Ref {
+        ripple::uint256 const* key;
+        std::uint32_t part;
+        std::uint32_t index;
+    };
+    std::vector<Ref> refs;
+    for (std::uint32_t p = 0; p < parts.size(); ++p) {
+        for (std::uint32_t i = 0; i < parts[p].keys.size(); ++i) {
+            refs.push_back({&parts[p].keys[i], p, i});
+        }
+        parts[p].offsets.push_back(parts[p].blob.size());
+    }
+    std::sort(refs.begin(), refs.end(), [](Ref const& a, Ref const& b) {
+        return *a.key < *b.key;
+    });
+
+    auto state = std::make_shared<MaterializedState>();
+    state->root = root;
+    state->keys.reserve(refs.size());
+    state->types.reserve(refs.size());
+    state->offsets.reserve(refs.size() + 1);
+    // Where each entry of each part goes in the merged blob.
+    std::vector<std::vector<std::uint64_t>> targets(parts.size());
+    for (std::uint32_t p = 0; p < parts.size(); ++p) {
+        targets[p].resize(parts[p].keys.size());
+    }
+    std::uint64_t nbytes = 0;
+    for (auto const& ref : refs) {
+        auto const& part = parts[ref.part];
+        state->keys.push_back(*ref.key);
+        state->types.push_back(part.types[ref.index]);
+        state->offsets.push_back(nbytes);
+        targets[ref.part][ref.index] = nbytes;
+        nbytes += part.offsets[ref.index + 1] - part.offsets[ref.index];
+    }
+    state->offsets.push_back(nbytes);
+    refs = {};
+
+    // Copy one part at a time into the merged blob,
+    // whose pages are untouched until written,
+    // and free each part once it is copied,
+    // so that the leaves are held about once, not twice.
+    state->blob.resize(nbytes);
+    for (std::uint32_t p = 0; p < parts.size(); ++p) {
+        auto const& part = parts[p];
+        for (std::size_t i = 0; i < part.keys.size(); ++i) {
+            auto size = part.offsets[i + 1] - part.offsets[i];
+            std::memcpy(
+                state->blob.data() + targets[p][i], part.blob.data() + part.offsets[i], size);
+        }
+        parts[p] = Part{};
+        targets[p] = {};
+    }
+
+    std::shared_ptr<MaterializedState const> result = std::move(state);
+    db.materialized_.store(result);
+    return result;
+}
+
+std::shared_ptr<MaterializedState const> materialized(
+    Database const& db, ripple::uint256 const& root)
+{
+    auto state = db.materialized_.load();
+    if (state && state->root == root) {
+        return state;
+    }
+    return {};
+}
+
+}
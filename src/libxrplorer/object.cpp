@@ -0,0 +1,55 @@
+#include <xrplorer/object.hpp>
+#include <xrplorer/shamap.hpp>
+
+#include <fmt/core.h>
+#include <xrpl/basics/Slice.h>
+#include <xrpl/protocol/HashPrefix.h>
+#include <xrpl/protocol/SField.h>
+#include <xrpl/protocol/Serializer.h>
+#include <xrpl/protocol/detail/STVar.h>
+
+#include <memory>
+
+namespace xrplorer {
+
+std::optional<InnerNode> decodeInner(std::shared_ptr<ripple::NodeObject> const& object) {
+    if (ripple::deserializePrefix(object) != ripple::HashPrefix::innerNode) {
+        return std::nullopt;
+    }
+    InnerNode inner{object->getHash(), {}};
+    ripple::SerialIter sit{ripple::makeSlice(object->getData())};
+    // Consume the prefix.
+    sit.get32();
+    for (auto& child : inner.children) {
+        child = sit.get256();
+    }
+    return inner;
+}
+
+Transaction decodeTransaction(std::shared_ptr<ripple::NodeObject> const& object) {
+    auto leaf = splitLeaf(object);
+    if (!leaf) {
+        throw Exception{
+            TYPE_UNKNOWN, fmt::format("/nodes/{}", object->getHash()), "not a transaction"};
+    }
+    // The item is the transaction and its metadata,
+    // each prefixed by its length.
+    ripple::SerialIter sit{leaf->data};
+    auto sliceTx = sit.getSlice(sit.getVLDataLength());
+    auto sliceMeta = sit.getSlice(sit.getVLDataLength());
+    ripple::SerialIter sitTx{sliceTx};
+    ripple::SerialIter sitMeta{sliceMeta};
+    return {
+        std::make_shared<ripple::STTx const>(sitTx),
+        std::make_shared<ripple::STObject const>(sitMeta, ripple::sfMetadata),
+    };
+}
+
+std::shared_ptr<ripple::STBase const> copyField(ripple::STBase const& field) {
+    // `STBase::copy` is private, but `STVar` may call it,
+    // and holds the copy for as long as it lives.
+    auto var = std::make_shared<ripple::detail::STVar const>(field);
+    return std::shared_ptr<ripple::STBase const>{var, &var->get()};
+}
+
+}
@@ -32,7 +32,7 @@ std::string_view OperatingSystem::gethostname() const {
 }
 
 void OperatingSystem::sethostname(std::string_view hostname) {
-    db_ = std::make_unique<Database>(hostname);
+    db_ = std::make_shared<Database>(hostname, dbOptions_);
     hostname_ = hostname;
 }
 
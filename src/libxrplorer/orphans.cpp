@@ -0,0 +1,65 @@
+#include <xrplorer/orphans.hpp>
+#include <xrplorer/digest-set.hpp>
+#include <xrplorer/ledger.hpp>
+#include <xrplorer/walk.hpp>
+
+#include <atomic>
+#include <vector>
+
+namespace xrplorer {
+
+OrphanTotals findOrphans(
+    Database& db,
+    std::filesystem::path const& directory,
+    NodePtr const& anchor,
+    std::uint32_t from,
+    std::uint32_t to,
+    OrphanVisitor const& visitor,
+    std::optional<unsigned int> workers)
+{
+    auto headers = collectLedgers(db, anchor, from, to);
+    std::vector<ripple::uint256> roots;
+    roots.reserve(headers.size());
+    for (auto const& header : headers) {
+        roots.push_back(header.hash);
+    }
+
+    // The filter admits each digest once,
+    // so the set holds every reachable digest, present or not.
+    DigestSet reachable;
+    std::atomic<std::uint64_t> missing{0};
+    walk(db, roots,
+        [&](unsigned int, ripple::uint256 const&, NodePtr const& object, unsigned int) {
+            if (!object) {
+                missing.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            return true;
+        },
+        workers,
+        [&](ripple::uint256 const& digest) {
+            return reachable.insert(digest);
+        });
+
+    std::atomic<std::uint64_t> orphans{0}, orphanBytes{0};
+    OrphanTotals totals;
+    totals.scan = scanKeys(db, directory,
+        [&](unsigned int worker, ripple::uint256 const& digest, std::size_t stored) {
+            if (reachable.contains(digest)) {
+                return;
+            }
+            orphans.fetch_add(1, std::memory_order_relaxed);
+            orphanBytes.fetch_add(stored, std::memory_order_relaxed);
+            if (visitor) {
+                visitor(worker, digest, stored);
+            }
+        },
+        workers);
+    totals.reachable = reachable.size();
+    totals.missing = missing;
+    totals.orphans = orphans;
+    totals.orphanBytes = orphanBytes;
+    return totals;
+}
+
+}
@@ -0,0 +1,112 @@
+#include <xrplorer/proof.hpp>
+#include <xrplorer/shamap.hpp>
+#include <xrplorer/shims.hpp>
+
+#include <fmt/core.h>
+#include <xrpl/basics/Slice.h>
+#include <xrpl/basics/safe_cast.h>
+#include <xrpl/protocol/HashPrefix.h>
+#include <xrpl/protocol/Serializer.h>
+
+#include <algorithm>
+#include <span>
+
+namespace xrplorer {
+
+bool Proof::included() const {
+    if (!leaf) {
+        return false;
+    }
+    auto split = splitLeaf(leaf);
+    return split && split->key == key;
+}
+
+struct ProofWalk {
+    Database& db;
+    ProofBatch& batch;
+    std::vector<ProofLevel> path;
+
+    NodePtr fetch(ripple::uint256 const& digest) {
+        ++batch.fetches;
+        auto object = db.fetch(digest);
+        if (!object) {
+            throw Exception{NODE_MISSING, fmt::format("/nodes/{}", digest), "node missing"};
+        }
+        return object;
+    }
+
+    void finish(std::span<ripple::uint256 const> keys, NodePtr const& leaf) {
+        for (auto const& key : keys) {
+            batch.proofs.push_back({key, path, leaf});
+        }
+    }
+
+    void visit(NodePtr const& object, std::span<ripple::uint256 const> keys, unsigned int depth) {
+        auto const& slice = ripple::makeSlice(object->getData());
+        ripple::SerialIter sit{slice};
+        auto prefix = ripple::safe_cast<ripple::HashPrefix>(sit.get32());
+        if (prefix != ripple::HashPrefix::innerNode || depth >= MAX_DEPTH) {
+            return finish(keys, object);
+        }
+        auto& level = path.emplace_back();
+        level.digest = object->getHash();
+        for (auto& branch : level.branches) {
+            branch = sit.get256();
+        }
+        // The keys are sorted, so those under one branch are adjacent.
+        for (auto it = keys.begin(); it != keys.end();) {
+            auto branch = ripple::selectBranch(*it, depth);
+            auto end = std::find_if(it, keys.end(), [&](ripple::uint256 const& key) {
+                return ripple::selectBranch(key, depth) != branch;
+            });
+            std::span<ripple::uint256 const> group{it, end};
+            // `level` may move as the path grows.
+            auto childDigest = path[depth].branches[branch];
+            if (childDigest == beast::zero) {
+                finish(group, nullptr);
+            } else {
+                visit(fetch(childDigest), group, depth + 1);
+            }
+            it = end;
+        }
+        path.pop_back();
+    }
+};
+
+ProofBatch prove(
+    Database& db, ripple::uint256 const& root, std::vector<ripple::uint256> keys)
+{
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    ProofBatch batch;
+    if (keys.empty()) {
+        return batch;
+    }
+    batch.proofs.reserve(keys.size());
+    ProofWalk walk{db, batch, {}};
+    walk.visit(walk.fetch(root), keys, 0);
+    return batch;
+}
+
+bool verify(Proof const& proof, ripple::uint256 const& root) {
+    ripple::uint256 digest;
+    if (proof.leaf) {
+        auto const& data = proof.leaf->getData();
+        digest = ripple::Serializer{data.data(), data.size()}.getSHA512Half();
+    }
+    for (auto depth = proof.path.size(); depth-- > 0;) {
+        auto const& level = proof.path[depth];
+        if (level.branches[ripple::selectBranch(proof.key, depth)] != digest) {
+            return false;
+        }
+        ripple::Serializer s;
+        s.add32(ripple::HashPrefix::innerNode);
+        for (auto const& branch : level.branches) {
+            s.addBitString(branch);
+        }
+        digest = s.getSHA512Half();
+    }
+    return digest == root;
+}
+
+}
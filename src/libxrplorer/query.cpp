@@ -0,0 +1,71 @@
+#include <xrplorer/query.hpp>
+#include <xrplorer/filesystem.hpp>
+#include <xrplorer/ledger.hpp>
+#include <xrplorer/shamap.hpp>
+#include <xrplorer/shims.hpp>
+
+#include <xrpl/protocol/HashPrefix.h>
+#include <xrpl/protocol/Indexes.h>
+
+namespace xrplorer {
+
+Resolution resolve(OperatingSystem& os, std::string_view path) {
+    return command(os, path, Action::RESOLVE);
+}
+
+std::optional<ripple::LedgerHeader> ledger(
+    Database& db, ripple::uint256 const& digest)
+{
+    auto object = db.fetch(digest);
+    if (!object || ripple::deserializePrefix(object) != ripple::HashPrefix::ledgerMaster) {
+        return std::nullopt;
+    }
+    return ripple::deserializePrefixedHeader(object);
+}
+
+std::optional<InnerNode> inner(Database& db, ripple::uint256 const& digest) {
+    auto object = db.fetch(digest);
+    if (!object) {
+        return std::nullopt;
+    }
+    return decodeInner(object);
+}
+
+std::shared_ptr<ripple::STLedgerEntry const> entry(
+    Database& db, ripple::LedgerHeader const& header, ripple::uint256 const& key)
+{
+    auto object = readLeaf(db, header, key);
+    if (!object) {
+        return {};
+    }
+    return std::make_shared<ripple::STLedgerEntry const>(splitLeaf(object)->sle());
+}
+
+std::shared_ptr<ripple::STLedgerEntry const> account(
+    Database& db, ripple::LedgerHeader const& header, ripple::AccountID const& account)
+{
+    auto sle = entry(db, header, ripple::keylet::account(account).key);
+    if (sle && sle->getType() != ripple::ltACCOUNT_ROOT) {
+        return {};
+    }
+    return sle;
+}
+
+std::optional<Transaction> transaction(
+    Database& db, ripple::LedgerHeader const& header, ripple::uint256 const& txid)
+{
+    if (header.txHash == beast::zero) {
+        return std::nullopt;
+    }
+    auto root = db.fetch(header.txHash);
+    if (!root) {
+        return std::nullopt;
+    }
+    auto object = findLeaf(db, root, txid);
+    if (!object) {
+        return std::nullopt;
+    }
+    return decodeTransaction(object);
+}
+
+}
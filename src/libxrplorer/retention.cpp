@@ -0,0 +1,59 @@
+#include <xrplorer/retention.hpp>
+#include <xrplorer/digest-set.hpp>
+#include <xrplorer/ledger.hpp>
+#include <xrplorer/shims.hpp>
+#include <xrplorer/walk.hpp>
+
+#include <atomic>
+#include <vector>
+
+namespace xrplorer {
+
+void analyzeRetention(
+    Database& db,
+    NodePtr const& anchor,
+    std::uint32_t from,
+    std::uint32_t to,
+    RetentionVisitor const& visitor,
+    std::optional<unsigned int> walkers)
+{
+    // Collect the state roots newest first, then visit them oldest first.
+    auto headers = collectLedgers(db, anchor, from, to);
+
+    DigestSet seen;
+    LedgerRetention total;
+    for (auto it = headers.rbegin(); it != headers.rend(); ++it) {
+        std::atomic<std::uint64_t> nodes{0}, bytes{0}, missing{0}, shared{0};
+        walk(db, {it->accountHash},
+            [&](unsigned int, ripple::uint256 const&, NodePtr const& object, unsigned int) {
+                if (!object) {
+                    missing.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                nodes.fetch_add(1, std::memory_order_relaxed);
+                bytes.fetch_add(object->getData().size(), std::memory_order_relaxed);
+                return true;
+            },
+            walkers,
+            [&](ripple::uint256 const& digest) {
+                if (seen.insert(digest)) {
+                    return true;
+                }
+                shared.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            });
+        LedgerRetention ledger;
+        ledger.seq = it->seq;
+        ledger.nodes = nodes;
+        ledger.bytes = bytes;
+        ledger.missing = missing;
+        ledger.shared = shared;
+        total.workingNodes += ledger.nodes;
+        total.workingBytes += ledger.bytes;
+        ledger.workingNodes = total.workingNodes;
+        ledger.workingBytes = total.workingBytes;
+        visitor(ledger);
+    }
+}
+
+}
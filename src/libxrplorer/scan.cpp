@@ -0,0 +1,293 @@
+#include <xrplorer/scan.hpp>
+#include <xrplorer/shims.hpp>
+#include <xrplorer/walk.hpp>
+
+#include <xrpl/basics/ByteUtilities.h>
+#include <xrpl/nodestore/detail/DecodedBlob.h>
+#include <xrpl/nodestore/detail/codec.h>
+#include <xrpl/protocol/HashPrefix.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace xrplorer {
+
+// See `nudb/detail/format.hpp`.
+// Integers are big-endian.
+//
+//     header: type "nudb.dat" (8), version (2), uid (8), appnum (8),
+//         key size (2), reserved (64)
+//     object record: value size (6), key, value
+//     spill record: zero (6), bucket size (2), bucket
+constexpr std::string_view DAT_TYPE{"nudb.dat"};
+constexpr std::size_t NBYTES_DAT_HEADER = 92;
+constexpr std::size_t OFFSET_KEY_SIZE = 26;
+// Far beyond any node object, compressed or not.
+constexpr std::uint64_t MAX_VALUE_SIZE = ripple::megabytes(64);
+
+static std::uint64_t readBigEndian(std::uint8_t const* data, std::size_t size) {
+    std::uint64_t value = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+        value = (value << 8) | data[i];
+    }
+    return value;
+}
+
+void StoreStats::add(NodePtr const& object, std::size_t stored) {
+    auto prefix = ripple::deserializePrefix(object);
+    auto& stats = prefixes[static_cast<std::uint32_t>(prefix)];
+    ++stats.count;
+    stats.bytes += object->getData().size();
+    stats.stored += stored;
+    if (prefix == ripple::HashPrefix::ledgerMaster) {
+        ledgers.push_back(ripple::deserializePrefixedHeader(object).seq);
+    }
+}
+
+void StoreStats::merge(StoreStats const& rhs) {
+    for (auto const& [prefix, stats] : rhs.prefixes) {
+        auto& lhs = prefixes[prefix];
+        lhs.count += stats.count;
+        lhs.bytes += stats.bytes;
+        lhs.stored += stats.stored;
+    }
+    ledgers.insert(ledgers.end(), rhs.ledgers.begin(), rhs.ledgers.end());
+    std::sort(ledgers.begin(), ledgers.end());
+}
+
+struct Batch {
+    std::vector<std::uint8_t> buffer;
+    // The offsets in `buffer` of the object records.
+    std::vector<std::size_t> records;
+};
+
+/**
+ * Called from any worker for every object record.
+ * Returns `false` if the record is corrupt.
+ */
+using RecordHandler = std::function<bool(
+    unsigned int worker,
+    std::uint8_t const* key,
+    std::uint8_t const* value,
+    std::size_t size)>;
+
+static ScanTotals scanRecords(
+    unsigned int nworkers,
+    std::filesystem::path const& directory,
+    RecordHandler const& handler,
+    std::size_t readSize)
+{
+    auto path = directory / "nudb.dat";
+    std::ifstream in{path, std::ios::binary};
+    if (!in) {
+        throw Exception{DOES_NOT_EXIST, path, "no such file or directory"};
+    }
+    std::uint8_t header[NBYTES_DAT_HEADER];
+    in.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (!in || std::memcmp(header, DAT_TYPE.data(), DAT_TYPE.size()) != 0) {
+        throw Exception{TYPE_UNKNOWN, path, "not a NuDB data file"};
+    }
+    auto keySize = readBigEndian(header + OFFSET_KEY_SIZE, 2);
+    if (keySize != ripple::uint256::bytes) {
+        throw Exception{TYPE_UNKNOWN, path, "unexpected key size"};
+    }
+    std::error_code ec;
+    auto fileSize = std::filesystem::file_size(path, ec);
+    if (ec) {
+        throw Exception{DOES_NOT_EXIST, path, ec.message()};
+    }
+
+    ScanTotals totals;
+    totals.bytes = NBYTES_DAT_HEADER;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Batch> queue;
+    bool done = false;
+    std::exception_ptr error;
+    std::atomic<std::uint64_t> corrupt{0};
+
+    auto work = [&](unsigned int worker) {
+        while (true) {
+            Batch batch;
+            {
+                std::unique_lock lock{mutex};
+                cv.wait(lock, [&]() { return done || error || !queue.empty(); });
+                if (error || queue.empty()) {
+                    return;
+                }
+                batch = std::move(queue.front());
+                queue.pop_front();
+                cv.notify_all();
+            }
+            for (auto offset : batch.records) {
+                auto const* record = batch.buffer.data() + offset;
+                auto size = readBigEndian(record, 6);
+                auto const* key = record + 6;
+                auto const* value = key + keySize;
+                try {
+                    if (!handler(worker, key, value, size)) {
+                        corrupt.fetch_add(1, std::memory_order_relaxed);
+                    }
+                } catch (...) {
+                    std::lock_guard lock{mutex};
+                    error = std::current_exception();
+                    cv.notify_all();
+                    return;
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(nworkers);
+    for (auto i = 0u; i < nworkers; ++i) {
+        threads.emplace_back(work, i);
+    }
+
+    // Read in large chunks, carrying any partial record at the end of one
+    // to the start of the next.
+    std::vector<std::uint8_t> carry;
+    // The offset in the file of the front of the carry.
+    std::uint64_t position = NBYTES_DAT_HEADER;
+    // Whether a record claims a size that cannot be right,
+    // after which no record boundary can be trusted.
+    bool broken = false;
+    while (true) {
+        Batch batch;
+        batch.buffer = std::move(carry);
+        auto start = batch.buffer.size();
+        batch.buffer.resize(start + readSize);
+        in.read(reinterpret_cast<char*>(batch.buffer.data() + start), readSize);
+        auto count = static_cast<std::size_t>(in.gcount());
+        batch.buffer.resize(start + count);
+        totals.bytes += count;
+
+        std::size_t offset = 0;
+        auto const& buffer = batch.buffer;
+        while (offset + 6 <= buffer.size()) {
+            auto size = readBigEndian(buffer.data() + offset, 6);
+            std::size_t length;
+            if (size == 0) {
+                if (offset + 8 > buffer.size()) {
+                    break;
+                }
+                length = 8 + readBigEndian(buffer.data() + offset + 6, 2);
+            } else {
+                length = 6 + keySize + size;
+            }
+            if (size > MAX_VALUE_SIZE || position + offset + length > fileSize) {
+                broken = true;
+                break;
+            }
+            if (offset + length > buffer.size()) {
+                break;
+            }
+            ++totals.records;
+            if (size == 0) {
+                ++totals.spills;
+            } else {
+                batch.records.push_back(offset);
+            }
+            offset += length;
+        }
+        if (broken) {
+            carry.clear();
+        } else {
+            carry.assign(buffer.begin() + offset, buffer.end());
+        }
+        position += offset;
+
+        bool last = count < readSize || broken;
+        {
+            std::unique_lock lock{mutex};
+            // Keep at most one batch waiting per worker.
+            cv.wait(lock, [&]() { return error || queue.size() < nworkers; });
+            if (!error) {
+                queue.push_back(std::move(batch));
+            }
+            if (last || error) {
+                done = true;
+            }
+            cv.notify_all();
+        }
+        if (last || error) {
+            break;
+        }
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    totals.corrupt = corrupt;
+    // A partial record at the end of the file, e.g. from an interrupted write,
+    // or a record whose size is corrupt, where the scan stops.
+    totals.corrupt += (broken || !carry.empty()) ? 1 : 0;
+    return totals;
+}
+
+ScanTotals scanStore(
+    Database const& db,
+    std::filesystem::path const& directory,
+    StoreVisitor const& visitor,
+    std::optional<unsigned int> workers,
+    std::size_t readSize)
+{
+    auto nworkers = countWalkers(db, workers);
+    // One decompression buffer per worker.
+    std::vector<std::vector<std::uint8_t>> buffers(nworkers);
+    return scanRecords(nworkers, directory,
+        [&](unsigned int worker, std::uint8_t const* key, std::uint8_t const* value, std::size_t size) {
+            auto& buffer = buffers[worker];
+            auto factory = [&buffer](std::size_t size) {
+                buffer.resize(size);
+                return buffer.data();
+            };
+            std::pair<void const*, std::size_t> result;
+            try {
+                result = ripple::NodeStore::nodeobject_decompress(value, size, factory);
+            } catch (std::exception const&) {
+                return false;
+            }
+            ripple::NodeStore::DecodedBlob decoded{
+                key, result.first, static_cast<int>(result.second)};
+            if (!decoded.wasOk()) {
+                return false;
+            }
+            visitor(worker, decoded.createObject(), size);
+            return true;
+        },
+        readSize);
+}
+
+ScanTotals scanKeys(
+    Database const& db,
+    std::filesystem::path const& directory,
+    KeyVisitor const& visitor,
+    std::optional<unsigned int> workers,
+    std::size_t readSize)
+{
+    return scanRecords(countWalkers(db, workers), directory,
+        [&](unsigned int worker, std::uint8_t const* key, std::uint8_t const*, std::size_t size) {
+            visitor(worker, ripple::uint256::fromVoid(key), size);
+            return true;
+        },
+        readSize);
+}
+
+}
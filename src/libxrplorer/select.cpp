@@ -0,0 +1,519 @@
+#include <xrplorer/select.hpp>
+#include <xrplorer/materialize.hpp>
+#include <xrplorer/walk.hpp>
+
+#include <fmt/core.h>
+#include <xrpl/basics/Slice.h>
+#include <xrpl/basics/StringUtilities.h> // strUnHex
+#include <xrpl/protocol/AccountID.h>
+#include <xrpl/protocol/HashPrefix.h>
+#include <xrpl/protocol/Serializer.h>
+#include <xrpl/protocol/UintTypes.h>
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace xrplorer {
+
+static std::invalid_argument error(std::string message) {
+    return std::invalid_argument{std::move(message)};
+}
+
+static std::vector<std::string_view> tokenize(std::string_view text) {
+    constexpr std::string_view OPERATOR_CHARS{"=!<>"};
+    std::vector<std::string_view> tokens;
+    std::size_t i = 0;
+    while (i < text.size()) {
+        if (std::isspace(static_cast<unsigned char>(text[i]))) {
+            ++i;
+            continue;
+        }
+        auto j = i;
+        bool isOperator = OPERATOR_CHARS.find(text[i]) != std::string_view::npos;
+        while (j < text.size()
+            && !std::isspace(static_cast<unsigned char>(text[j]))
+            && (OPERATOR_CHARS.find(text[j]) != std::string_view::npos) == isOperator)
+        {
+            ++j;
+        }
+        tokens.push_back(text.substr(i, j - i));
+        i = j;
+    }
+    return tokens;
+}
+
+static std::optional<Op> parseOp(std::string_view token) {
+    if (token == "==" || token == "=") return Op::EQ;
+    if (token == "!=") return Op::NE;
+    if (token == "<") return Op::LT;
+    if (token == "<=") return Op::LE;
+    if (token == ">") return Op::GT;
+    if (token == ">=") return Op::GE;
+    return std::nullopt;
+}
+
+static bool isInteger(ripple::SerializedTypeID type) {
+    return type == ripple::STI_UINT8
+        || type == ripple::STI_UINT16
+        || type == ripple::STI_UINT32
+        || type == ripple::STI_UINT64;
+}
+
+/** Return the width in bytes of a fixed-width hash type, or 0. */
+static std::size_t hashWidth(ripple::SerializedTypeID type) {
+    switch (type) {
+        case ripple::STI_UINT96: return 12;
+        case ripple::STI_UINT128: return 16;
+        case ripple::STI_UINT160: return 20;
+        case ripple::STI_UINT192: return 24;
+        case ripple::STI_UINT256: return 32;
+        case ripple::STI_UINT384: return 48;
+        case ripple::STI_UINT512: return 64;
+        default: return 0;
+    }
+}
+
+static std::optional<long double> parseNumber(std::string_view token) {
+    long double number;
+    auto end = token.data() + token.size();
+    if (token.starts_with("0x")) {
+        std::uint64_t value;
+        auto [ptr, ec] = std::from_chars(token.data() + 2, end, value, 16);
+        if (ec != std::errc{} || ptr != end) {
+            return std::nullopt;
+        }
+        return value;
+    }
+    try {
+        std::size_t size;
+        number = std::stold(std::string{token}, &size);
+        if (size != token.size()) {
+            return std::nullopt;
+        }
+    } catch (...) {
+        return std::nullopt;
+    }
+    return number;
+}
+
+static std::optional<ripple::Blob> parseHex(std::string_view token) {
+    return ripple::strUnHex(std::string{token});
+}
+
+static std::optional<ripple::Blob> parseAccount(std::string_view token) {
+    auto account = ripple::parseBase58<ripple::AccountID>(std::string{token});
+    if (!account) {
+        return std::nullopt;
+    }
+    return ripple::Blob{account->begin(), account->end()};
+}
+
+static std::optional<ripple::Blob> parseCurrency(std::string_view token) {
+    ripple::Currency currency;
+    if (!ripple::to_currency(currency, std::string{token})) {
+        return std::nullopt;
+    }
+    return ripple::Blob{currency.begin(), currency.end()};
+}
+
+static Condition compileCondition(
+    std::string_view name, std::string_view opToken, std::string_view value)
+{
+    Condition condition;
+    condition.part = Part::WHOLE;
+    auto dot = name.rfind('.');
+    if (dot != std::string_view::npos) {
+        auto part = name.substr(dot + 1);
+        if (part == "currency") {
+            condition.part = Part::CURRENCY;
+        } else if (part == "issuer") {
+            condition.part = Part::ISSUER;
+        } else {
+            throw error(fmt::format("{}: unknown part", name));
+        }
+        name = name.substr(0, dot);
+    }
+    auto const& field = ripple::SField::getField(std::string{name});
+    if (field == ripple::sfInvalid) {
+        throw error(fmt::format("{}: unknown field", name));
+    }
+    condition.field = &field;
+    auto op = parseOp(opToken);
+    if (!op) {
+        throw error(fmt::format("{}: unknown operator", opToken));
+    }
+    condition.op = *op;
+    auto type = field.fieldType;
+    if (condition.part != Part::WHOLE && type != ripple::STI_AMOUNT) {
+        throw error(fmt::format("{}: only amounts have a currency and issuer", name));
+    }
+
+    std::optional<ripple::Blob> bytes;
+    if (isInteger(type) || (type == ripple::STI_AMOUNT && condition.part == Part::WHOLE)) {
+        auto number = parseNumber(value);
+        if (!number && field == ripple::sfLedgerEntryType) {
+            if (auto let = parseType(value)) {
+                number = static_cast<long double>(*let);
+            }
+        }
+        if (!number) {
+            throw error(fmt::format("{}: not a number", value));
+        }
+        condition.numeric = true;
+        condition.number = *number;
+        return condition;
+    }
+    condition.numeric = false;
+    if (auto width = hashWidth(type)) {
+        bytes = parseHex(value);
+        if (bytes && bytes->size() != width) {
+            bytes.reset();
+        }
+    } else if (type == ripple::STI_ACCOUNT || condition.part == Part::ISSUER) {
+        bytes = parseAccount(value);
+    } else if (condition.part == Part::CURRENCY) {
+        bytes = parseCurrency(value);
+    } else if (type == ripple::STI_VL) {
+        bytes = parseHex(value);
+    } else {
+        throw error(fmt::format("{}: field type not supported", name));
+    }
+    if (!bytes) {
+        throw error(fmt::format("{}: not a value for {}", value, name));
+    }
+    condition.bytes = std::move(*bytes);
+    return condition;
+}
+
+Predicate Predicate::compile(std::string_view text) {
+    auto tokens = tokenize(text);
+    Predicate predicate;
+    predicate.clauses.emplace_back();
+    std::size_t i = 0;
+    while (true) {
+        if (i + 3 > tokens.size()) {
+            throw error("expected: field operator value");
+        }
+        predicate.clauses.back().push_back(
+            compileCondition(tokens[i], tokens[i + 1], tokens[i + 2]));
+        i += 3;
+        if (i == tokens.size()) {
+            break;
+        }
+        if (tokens[i] == "or") {
+            predicate.clauses.emplace_back();
+        } else if (tokens[i] != "and") {
+            throw error(fmt::format("{}: expected `and` or `or`", tokens[i]));
+        }
+        ++i;
+    }
+    for (auto const& clause : predicate.clauses) {
+        for (auto const& condition : clause) {
+            auto const* field = condition.field;
+            if (std::find(predicate.fields.begin(), predicate.fields.end(), field)
+                == predicate.fields.end())
+            {
+                predicate.fields.push_back(field);
+                predicate.lastCode = std::max(predicate.lastCode, field->fieldCode);
+            }
+        }
+    }
+    return predicate;
+}
+
+/** Return the length of a variable-length value, and consume its prefix. */
+static std::optional<std::size_t> readVL(ripple::Slice& data) {
+    if (data.empty()) {
+        return std::nullopt;
+    }
+    std::size_t b0 = data[0];
+    if (b0 <= 192) {
+        data.remove_prefix(1);
+        return b0;
+    }
+    if (b0 <= 240) {
+        if (data.size() < 2) {
+            return std::nullopt;
+        }
+        auto size = 193 + (b0 - 193) * 256 + data[1];
+        data.remove_prefix(2);
+        return size;
+    }
+    if (b0 <= 254) {
+        if (data.size() < 3) {
+            return std::nullopt;
+        }
+        auto size = 12481 + (b0 - 241) * 65536 + data[1] * 256 + data[2];
+        data.remove_prefix(3);
+        return size;
+    }
+    return std::nullopt;
+}
+
+/**
+ * Return the size of a field value at the front of `data`,
+ * including any length prefix,
+ * or nothing if it cannot be read without deserializing it.
+ */
+static std::optional<std::size_t> valueSize(int type, ripple::Slice const& data) {
+    if (auto width = hashWidth(static_cast<ripple::SerializedTypeID>(type))) {
+        return width;
+    }
+    switch (type) {
+        case ripple::STI_UINT8: return 1;
+        case ripple::STI_UINT16: return 2;
+        case ripple::STI_UINT32: return 4;
+        case ripple::STI_UINT64: return 8;
+        case ripple::STI_AMOUNT:
+            if (data.empty()) {
+                return std::nullopt;
+            }
+            // The high bit is set for issued currencies.
+            return (data[0] & 0x80) ? 48 : 8;
+        case ripple::STI_VL:
+        case ripple::STI_ACCOUNT:
+        case ripple::STI_VECTOR256: {
+            auto rest = data;
+            auto size = readVL(rest);
+            if (!size) {
+                return std::nullopt;
+            }
+            return (data.size() - rest.size()) + *size;
+        }
+        default:
+            return std::nullopt;
+    }
+}
+
+/** Return the code of the field at the front of `data`, and consume its header. */
+static std::optional<int> readFieldCode(ripple::Slice& data) {
+    if (data.empty()) {
+        return std::nullopt;
+    }
+    int type = data[0] >> 4;
+    int code = data[0] & 0x0F;
+    data.remove_prefix(1);
+    if (type == 0) {
+        if (data.empty()) {
+            return std::nullopt;
+        }
+        type = data[0];
+        data.remove_prefix(1);
+    }
+    if (code == 0) {
+        if (data.empty()) {
+            return std::nullopt;
+        }
+        code = data[0];
+        data.remove_prefix(1);
+    }
+    return (type << 16) | code;
+}
+
+std::optional<ripple::Slice> findField(ripple::Slice data, ripple::SField const& field) {
+    while (!data.empty()) {
+        auto fieldCode = readFieldCode(data);
+        // Fields are serialized in order of their codes.
+        if (!fieldCode || *fieldCode > field.fieldCode) {
+            return std::nullopt;
+        }
+        auto type = *fieldCode >> 16;
+        auto size = valueSize(type, data);
+        if (!size || *size > data.size()) {
+            return std::nullopt;
+        }
+        if (*fieldCode == field.fieldCode) {
+            ripple::Slice value{data.data(), *size};
+            if (type == ripple::STI_VL
+                || type == ripple::STI_ACCOUNT
+                || type == ripple::STI_VECTOR256)
+            {
+                readVL(value);
+            }
+            return value;
+        }
+        data.remove_prefix(*size);
+    }
+    return std::nullopt;
+}
+
+static std::uint64_t readBigEndian(std::uint8_t const* data, std::size_t size) {
+    std::uint64_t value = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+        value = (value << 8) | data[i];
+    }
+    return value;
+}
+
+static long double amountValue(ripple::Slice const& value) {
+    auto bits = readBigEndian(value.data(), 8);
+    bool positive = bits & 0x4000000000000000ull;
+    long double number;
+    if (!(bits & 0x8000000000000000ull)) {
+        // Drops of XRP.
+        number = bits & 0x3FFFFFFFFFFFFFFFull;
+    } else {
+        auto mantissa = bits & 0x003FFFFFFFFFFFFFull;
+        auto exponent = static_cast<int>((bits >> 54) & 0xFF) - 97;
+        number = mantissa ? mantissa * std::pow(10.0L, exponent) : 0;
+    }
+    return positive ? number : -number;
+}
+
+static bool compare(Op op, int cmp) {
+    switch (op) {
+        case Op::EQ: return cmp == 0;
+        case Op::NE: return cmp != 0;
+        case Op::LT: return cmp < 0;
+        case Op::LE: return cmp <= 0;
+        case Op::GT: return cmp > 0;
+        case Op::GE: return cmp >= 0;
+    }
+    return false;
+}
+
+/** Test a condition against the serialized value of its field. */
+static bool test(Condition const& condition, ripple::Slice value) {
+    auto type = condition.field->fieldType;
+    if (condition.numeric) {
+        long double number = (type == ripple::STI_AMOUNT)
+            ? amountValue(value)
+            : readBigEndian(value.data(), value.size());
+        int cmp = (number < condition.number) ? -1 : (number > condition.number) ? 1 : 0;
+        return compare(condition.op, cmp);
+    }
+    if (type == ripple::STI_VL || type == ripple::STI_ACCOUNT) {
+        if (!readVL(value)) {
+            return false;
+        }
+    }
+    if (condition.part != Part::WHOLE) {
+        // An amount of XRP has no currency or issuer,
+        // which compare as zero.
+        static std::uint8_t const ZEROES[20] = {};
+        auto offset = (condition.part == Part::CURRENCY) ? 8 : 28;
+        value = (value.size() == 48)
+            ? ripple::Slice{value.data() + offset, 20}
+            : ripple::Slice{ZEROES, 20};
+    }
+    auto size = std::min(value.size(), condition.bytes.size());
+    int cmp = std::memcmp(value.data(), condition.bytes.data(), size);
+    if (cmp == 0) {
+        cmp = (value.size() < condition.bytes.size()) ? -1
+            : (value.size() > condition.bytes.size()) ? 1 : 0;
+    }
+    return compare(condition.op, cmp);
+}
+
+using Values = std::vector<std::pair<ripple::SField const*, ripple::Slice>>;
+
+static bool evaluate(
+    std::vector<std::vector<Condition>> const& clauses, Values const& values)
+{
+    auto find = [&](ripple::SField const* field) -> ripple::Slice const* {
+        for (auto const& [f, value] : values) {
+            if (f == field) {
+                return &value;
+            }
+        }
+        return nullptr;
+    };
+    return std::any_of(clauses.begin(), clauses.end(), [&](auto const& clause) {
+        return std::all_of(clause.begin(), clause.end(), [&](Condition const& condition) {
+            auto value = find(condition.field);
+            return value && test(condition, *value);
+        });
+    });
+}
+
+bool Predicate::operator() (Leaf const& leaf) const {
+    auto const& wanted = fields;
+    Values values;
+    auto data = leaf.data;
+    // Fields are serialized in order of their codes,
+    // so the scan can stop after the last wanted code.
+    while (!data.empty()) {
+        auto fieldCode = readFieldCode(data);
+        if (!fieldCode) {
+            break;
+        }
+        if (*fieldCode > lastCode) {
+            return evaluate(clauses, values);
+        }
+        auto size = valueSize(*fieldCode >> 16, data);
+        if (!size || *size > data.size()) {
+            break;
+        }
+        for (auto const* field : wanted) {
+            if (field->fieldCode == *fieldCode) {
+                values.emplace_back(field, ripple::Slice{data.data(), *size});
+            }
+        }
+        data.remove_prefix(*size);
+    }
+    if (data.empty()) {
+        return evaluate(clauses, values);
+    }
+    // Fall back to deserializing the entry
+    // and serializing each wanted field on its own.
+    auto sle = leaf.sle();
+    std::vector<ripple::Serializer> serialized(wanted.size());
+    values.clear();
+    for (std::size_t i = 0; i < wanted.size(); ++i) {
+        if (!sle.isFieldPresent(*wanted[i])) {
+            continue;
+        }
+        sle.peekAtPField(*wanted[i])->add(serialized[i]);
+        values.emplace_back(wanted[i], serialized[i].slice());
+    }
+    return evaluate(clauses, values);
+}
+
+std::vector<NodePtr> select(
+    Database& db,
+    ripple::uint256 const& root,
+    Predicate const& predicate,
+    std::optional<unsigned int> walkers)
+{
+    // A materialized state is scanned in key order, without a walk.
+    if (auto state = materialized(db, root)) {
+        std::vector<NodePtr> matches;
+        for (std::size_t i = 0; i < state->size(); ++i) {
+            if (predicate(state->leaf(i))) {
+                matches.push_back(state->object(i));
+            }
+        }
+        return matches;
+    }
+    // One list of matches per walker, merged at the end.
+    std::vector<std::vector<NodePtr>> matches(countWalkers(db, walkers));
+    walk(db, {root},
+        [&](unsigned int worker, ripple::uint256 const& digest, NodePtr const& object, unsigned int) {
+            if (!object) {
+                throw Exception{NODE_MISSING, fmt::format("/nodes/{}", digest), "node missing"};
+            }
+            if (ripple::deserializePrefix(object) != ripple::HashPrefix::leafNode) {
+                return true;
+            }
+            if (auto leaf = splitLeaf(object); leaf && predicate(*leaf)) {
+                matches[worker].push_back(object);
+            }
+            return false;
+        },
+        walkers);
+    std::vector<NodePtr> merged;
+    for (auto& list : matches) {
+        merged.insert(merged.end(), list.begin(), list.end());
+    }
+    std::sort(merged.begin(), merged.end(), [](auto const& a, auto const& b) {
+        return splitLeaf(a)->key < splitLeaf(b)->key;
+    });
+    return merged;
+}
+
+}
@@ -0,0 +1,243 @@
+#include <xrplorer/server.hpp>
+#include <xrplorer/context.hpp>
+#include <xrplorer/shell.hpp>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/read_until.hpp>
+#include <boost/asio/signal_set.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/system/system_error.hpp>
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace xrplorer {
+
+namespace asio = boost::asio;
+using local = asio::local::stream_protocol;
+using error_code = boost::system::error_code;
+
+// How often to trim the node store cache to its target size and age.
+constexpr auto SWEEP_INTERVAL = std::chrono::seconds(10);
+
+// Every response starts with its size in this many bytes, big-endian.
+constexpr std::size_t SIZE_BYTES = 8;
+
+static std::string encodeSize(std::uint64_t size) {
+    std::string bytes(SIZE_BYTES, '\0');
+    for (auto i = SIZE_BYTES; i-- > 0; size >>= 8) {
+        bytes[i] = static_cast<char>(size & 0xFF);
+    }
+    return bytes;
+}
+
+static std::uint64_t decodeSize(std::uint8_t const* bytes) {
+    std::uint64_t size = 0;
+    for (std::size_t i = 0; i < SIZE_BYTES; ++i) {
+        size = (size << 8) | bytes[i];
+    }
+    return size;
+}
+
+class Session : public std::enable_shared_from_this<Session> {
+private:
+    local::socket socket_;
+    OperatingSystem os_;
+    Shell shell_{os_};
+    std::string input_;
+    std::string output_;
+
+public:
+    Session(local::socket socket, OperatingSystem const& os)
+        : socket_(std::move(socket)), os_(os) {}
+
+    void read() {
+        asio::async_read_until(socket_, asio::dynamic_buffer(input_), '\n',
+            [self = shared_from_this()](error_code ec, std::size_t size) {
+                if (ec) {
+                    return;
+                }
+                std::string line = self->input_.substr(0, size - 1);
+                self->input_.erase(0, size);
+                self->execute(line);
+            });
+    }
+
+private:
+    void execute(std::string const& line) {
+        // Capture the output of the command in memory.
+        char* buffer = nullptr;
+        std::size_t size = 0;
+        os_.stdout = ::open_memstream(&buffer, &size);
+        if (!os_.stdout) {
+            // Answer without running the command, and keep the session.
+            std::string message = "cannot buffer output\n";
+            output_ = encodeSize(message.size()) + message;
+            return reply(false);
+        }
+        std::optional<int> status;
+        try {
+            status = shell_.execute(line);
+        } catch (Exception const& ex) {
+            fmt::print(os_.stdout, "{}: {}\n", ex.path.string(), ex.message);
+        } catch (std::exception const& ex) {
+            fmt::print(os_.stdout, "{}\n", ex.what());
+        } catch (...) {
+            fmt::print(os_.stdout, "unknown error\n");
+        }
+        std::fclose(os_.stdout);
+        os_.stdout = nullptr;
+        output_ = encodeSize(size);
+        output_.append(buffer, size);
+        std::free(buffer);
+        reply(status.has_value());
+    }
+
+    // Send `output_`, then read the next command unless the session is `done`.
+    void reply(bool done) {
+        asio::async_write(socket_, asio::buffer(output_),
+            [self = shared_from_this(), done](error_code ec, std::size_t) {
+                if (ec || done) {
+                    return;
+                }
+                self->read();
+            });
+    }
+};
+
+Server::Server(OperatingSystem& os, std::filesystem::path path, unsigned int threads)
+    : os_(os), path_(std::move(path)), threads_(std::max(threads, 1u))
+{}
+
+/**
+ * Remove a socket at `path` left behind by a server that did not exit cleanly,
+ * which would make the bind fail.
+ * Throws if anything else is there, or a server is listening on it.
+ */
+static void removeStaleSocket(asio::io_context& io, std::filesystem::path const& path) {
+    std::error_code ec;
+    auto status = std::filesystem::symlink_status(path, ec);
+    if (!std::filesystem::exists(status)) {
+        return;
+    }
+    if (!std::filesystem::is_socket(status)) {
+        throw boost::system::system_error{asio::error::address_in_use};
+    }
+    local::socket probe{io};
+    error_code refused;
+    probe.connect(local::endpoint{path.string()}, refused);
+    if (refused != asio::error::connection_refused) {
+        throw boost::system::system_error{asio::error::address_in_use};
+    }
+    std::filesystem::remove(path);
+}
+
+/** Return the device and inode of the file at `path`, if there is one. */
+static std::optional<std::pair<dev_t, ino_t>> fileId(std::filesystem::path const& path) {
+    struct ::stat st;
+    if (::lstat(path.c_str(), &st) != 0) {
+        return std::nullopt;
+    }
+    return std::pair{st.st_dev, st.st_ino};
+}
+
+void Server::run() {
+    asio::io_context io;
+
+    removeStaleSocket(io, path_);
+    local::acceptor acceptor{io, local::endpoint{path_.string()}};
+    // Remember the socket that this server bound,
+    // so that it never removes one that replaced it.
+    auto bound = fileId(path_);
+    std::function<void()> accept = [&]() {
+        acceptor.async_accept([&](error_code ec, local::socket socket) {
+            if (ec) {
+                return;
+            }
+            std::make_shared<Session>(std::move(socket), os_)->read();
+            accept();
+        });
+    };
+    accept();
+
+    asio::steady_timer timer{io};
+    std::function<void()> sweep = [&]() {
+        timer.expires_after(SWEEP_INTERVAL);
+        timer.async_wait([&](error_code ec) {
+            if (ec) {
+                return;
+            }
+            os_.db()->sweep();
+            sweep();
+        });
+    };
+    sweep();
+
+    asio::signal_set signals{io, SIGINT, SIGTERM};
+    signals.async_wait([&](error_code, int) {
+        io.stop();
+    });
+
+    std::vector<std::thread> threads;
+    threads.reserve(threads_);
+    for (auto i = 0u; i < threads_; ++i) {
+        threads.emplace_back([&]() { io.run(); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (bound && fileId(path_) == bound) {
+        std::filesystem::remove(path_);
+    }
+}
+
+struct Client::Impl {
+    asio::io_context io;
+    local::socket socket{io};
+};
+
+Client::Client(std::filesystem::path const& path) : impl_(std::make_unique<Impl>()) {
+    impl_->socket.connect(local::endpoint{path.string()});
+}
+
+Client::~Client() = default;
+
+std::optional<std::string> Client::request(std::string_view line) {
+    std::string message{line};
+    message.push_back('\n');
+    error_code ec;
+    asio::write(impl_->socket, asio::buffer(message), ec);
+    if (ec) {
+        return std::nullopt;
+    }
+    std::uint8_t header[SIZE_BYTES];
+    asio::read(impl_->socket, asio::buffer(header), ec);
+    if (ec) {
+        return std::nullopt;
+    }
+    std::string output(decodeSize(header), '\0');
+    asio::read(impl_->socket, asio::buffer(output), ec);
+    if (ec) {
+        return std::nullopt;
+    }
+    return output;
+}
+
+}
@@ -0,0 +1,249 @@
+#include <xrplorer/shamap.hpp>
+#include <xrplorer/materialize.hpp>
+
+#include <fmt/core.h>
+
+#include <xrpl/basics/safe_cast.h>
+#include <xrpl/protocol/HashPrefix.h>
+#include <xrpl/protocol/Serializer.h>
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace xrplorer {
+
+static bool isHex(std::string_view text) {
+    return std::all_of(text.begin(), text.end(), [](unsigned char c) {
+        return std::isxdigit(c);
+    });
+}
+
+/** Pad a key prefix to a full key. */
+static std::optional<ripple::uint256> pad(std::string_view prefix, char fill) {
+    if (prefix.size() > 2 * ripple::uint256::bytes || !isHex(prefix)) {
+        return std::nullopt;
+    }
+    std::string hex{prefix};
+    hex.resize(2 * ripple::uint256::bytes, fill);
+    ripple::uint256 key;
+    if (!key.parseHex(hex)) {
+        return std::nullopt;
+    }
+    return key;
+}
+
+std::optional<KeyRange> KeyRange::parse(std::string_view name) {
+    auto dots = name.find("..");
+    auto lower = name.substr(0, dots);
+    auto upper = (dots == std::string_view::npos) ? lower : name.substr(dots + 2);
+    if (dots == std::string_view::npos && lower.empty()) {
+        return std::nullopt;
+    }
+    auto first = pad(lower, '0');
+    auto last = pad(upper, 'F');
+    if (!first || !last) {
+        return std::nullopt;
+    }
+    return KeyRange{*first, *last};
+}
+
+KeyRange intersect(KeyRange const& a, KeyRange const& b) {
+    return {
+        std::max(a.first, b.first),
+        std::min(a.last, b.last),
+    };
+}
+
+ripple::SLE Leaf::sle() const {
+    ripple::SerialIter sit{data};
+    return ripple::SLE{sit, key};
+}
+
+std::optional<Leaf> splitLeaf(NodePtr const& object) {
+    auto slice = ripple::makeSlice(object->getData());
+    if (slice.size() < NBYTES_PREFIX + NBYTES_DIGEST) {
+        return std::nullopt;
+    }
+    ripple::SerialIter sit{slice};
+    auto prefix = ripple::safe_cast<ripple::HashPrefix>(sit.get32());
+    if (prefix != ripple::HashPrefix::leafNode && prefix != ripple::HashPrefix::txNode) {
+        return std::nullopt;
+    }
+    slice.remove_prefix(NBYTES_PREFIX);
+    auto size = slice.size() - NBYTES_DIGEST;
+    return Leaf{
+        ripple::uint256::fromVoid(slice.data() + size),
+        ripple::Slice{slice.data(), size},
+    };
+}
+
+std::optional<ripple::LedgerEntryType> peekType(ripple::Slice const& item) {
+    // Field header 0x11 is type STI_UINT16 (1), field 1 (sfLedgerEntryType).
+    if (item.size() < 3 || item[0] != 0x11) {
+        return std::nullopt;
+    }
+    return static_cast<ripple::LedgerEntryType>((item[1] << 8) | item[2]);
+}
+
+std::optional<ripple::LedgerEntryType> parseType(std::string_view name) {
+    if (name.starts_with("0x")) {
+        std::underlying_type_t<ripple::LedgerEntryType> value;
+        auto end = name.data() + name.size();
+        auto [ptr, ec] = std::from_chars(name.data() + 2, end, value, 16);
+        if (ec != std::errc{} || ptr != end) {
+            return std::nullopt;
+        }
+        return static_cast<ripple::LedgerEntryType>(value);
+    }
+    for (auto const& item : ripple::LedgerFormats::getInstance()) {
+        if (item.getName() == name) {
+            return item.getType();
+        }
+    }
+    return std::nullopt;
+}
+
+std::string_view typeName(ripple::LedgerEntryType type) {
+    auto item = ripple::LedgerFormats::getInstance().findByType(type);
+    return item ? std::string_view{item->getName()} : std::string_view{};
+}
+
+std::optional<ripple::uint256> branchDigest(NodePtr const& object, unsigned int branch) {
+    auto const& slice = ripple::makeSlice(object->getData());
+    ripple::SerialIter sit{slice};
+    auto prefix = ripple::safe_cast<ripple::HashPrefix>(sit.get32());
+    if (prefix != ripple::HashPrefix::innerNode) {
+        return std::nullopt;
+    }
+    sit.skip(NBYTES_DIGEST * branch);
+    return sit.get256();
+}
+
+/** Return `key` with the nibble at `depth` replaced by `nibble`. */
+static ripple::uint256 withNibble(ripple::uint256 key, unsigned int depth, unsigned int nibble) {
+    auto& byte = *(key.begin() + depth / 2);
+    if (depth & 1) {
+        byte = (byte & 0xF0) | nibble;
+    } else {
+        byte = (byte & 0x0F) | (nibble << 4);
+    }
+    return key;
+}
+
+/** Return `key` with every nibble after `depth` set to `F`. */
+static ripple::uint256 fillAfter(ripple::uint256 key, unsigned int depth) {
+    auto it = key.begin() + depth / 2;
+    if (!(depth & 1)) {
+        *it |= 0x0F;
+    }
+    std::fill(it + 1, key.end(), 0xFF);
+    return key;
+}
+
+/**
+ * Fetch a node under a root that is in the store,
+ * which should have every node under it.
+ */
+static NodePtr fetchChild(Database& db, ripple::uint256 const& digest) {
+    auto object = db.fetch(digest);
+    if (!object) {
+        throw Exception{NODE_MISSING, fmt::format("/nodes/{}", digest), "node missing"};
+    }
+    return object;
+}
+
+struct LeafWalk {
+    Database& db;
+    KeyRange const& range;
+    std::optional<ripple::LedgerEntryType> type;
+    LeafVisitor const& visitor;
+
+    // `lower` is the smallest key that could be under `object`.
+    bool visit(NodePtr const& object, ripple::uint256 const& lower, unsigned int depth) {
+        auto const& slice = ripple::makeSlice(object->getData());
+        ripple::SerialIter sit{slice};
+        auto prefix = ripple::safe_cast<ripple::HashPrefix>(sit.get32());
+        if (prefix != ripple::HashPrefix::innerNode) {
+            auto leaf = splitLeaf(object);
+            if (!leaf || !range.contains(leaf->key)) {
+                return true;
+            }
+            if (type && peekType(leaf->data) != type) {
+                return true;
+            }
+            return visitor(*leaf);
+        }
+        if (depth >= MAX_DEPTH) {
+            return true;
+        }
+        for (auto i = 0u; i < ripple::SHAMapInnerNode::branchFactor; ++i) {
+            auto childDigest = sit.get256();
+            if (childDigest == beast::zero) {
+                continue;
+            }
+            auto childLower = withNibble(lower, depth, i);
+            if (range.last < childLower || fillAfter(childLower, depth) < range.first) {
+                continue;
+            }
+            auto child = fetchChild(db, childDigest);
+            if (!visit(child, childLower, depth + 1)) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+bool visitLeaves(
+    Database& db,
+    NodePtr const& root,
+    KeyRange const& range,
+    std::optional<ripple::LedgerEntryType> type,
+    LeafVisitor const& visitor)
+{
+    if (!root || range.empty()) {
+        return true;
+    }
+    if (auto state = materialized(db, root->getHash())) {
+        return state->visit(range, type, visitor);
+    }
+    LeafWalk walk{db, range, type, visitor};
+    return walk.visit(root, ripple::uint256{}, 0);
+}
+
+NodePtr findLeaf(Database& db, NodePtr const& root, ripple::uint256 const& key) {
+    if (auto state = root ? materialized(db, root->getHash()) : nullptr) {
+        auto i = state->find(key);
+        return i ? state->object(*i) : nullptr;
+    }
+    NodePtr object{root};
+    for (auto depth = 0u; object && depth < MAX_DEPTH; ++depth) {
+        auto const& slice = ripple::makeSlice(object->getData());
+        ripple::SerialIter sit{slice};
+        auto prefix = ripple::safe_cast<ripple::HashPrefix>(sit.get32());
+        if (prefix != ripple::HashPrefix::innerNode) {
+            break;
+        }
+        auto childIndex = ripple::selectBranch(key, depth);
+        sit.skip(NBYTES_DIGEST * childIndex);
+        auto childDigest = sit.get256();
+        if (childDigest == beast::zero) {
+            return {};
+        }
+        object = fetchChild(db, childDigest);
+    }
+    if (!object) {
+        return {};
+    }
+    auto leaf = splitLeaf(object);
+    if (!leaf || leaf->key != key) {
+        return {};
+    }
+    return object;
+}
+
+}
@@ -1,16 +1,51 @@
 #include <xrplorer/shell.hpp>
 #include <xrplorer/context.hpp>
+#include <xrplorer/exists.hpp>
+#include <xrplorer/extract.hpp>
 #include <xrplorer/filesystem.hpp>
+#include <xrplorer/history.hpp>
+#include <xrplorer/materialize.hpp>
+#include <xrplorer/orphans.hpp>
+#include <xrplorer/proof.hpp>
+#include <xrplorer/retention.hpp>
+#include <xrplorer/scan.hpp>
+#include <xrplorer/select.hpp>
+#include <xrplorer/server.hpp>
+#include <xrplorer/shamap.hpp>
+#include <xrplorer/shims.hpp>
+#include <xrplorer/snapshot.hpp>
+#include <xrplorer/stat.hpp>
+#include <xrplorer/trace.hpp>
+#include <xrplorer/walk.hpp>
 
+#include <argparse/argparse.hpp>
 #include <boost/program_options/parsers.hpp>
 #include <fmt/core.h>
 #include <fmt/std.h>
 #include <readline/readline.h>
 #include <readline/history.h>
+#include <xrpl/basics/ByteUtilities.h> // megabytes()
+#include <xrpl/basics/base_uint.h>
+#include <xrpl/basics/chrono.h>
+#include <xrpl/basics/strHex.h>
+#include <xrpl/protocol/AccountID.h>
+#include <xrpl/protocol/Indexes.h>
 
+#include <algorithm>
 #include <cassert>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
 #include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
 #include <string_view>
+#include <thread>
+#include <vector>
 
 using namespace std::literals;
 
@@ -45,78 +80,446 @@ public:
 };
 
 int Shell::main(int argc, char** argv) {
-    // Copy the default nodestore path from the example rippled.cfg.
-    char const* hostname = (argc > 1) ? argv[1] : "/var/lib/rippled/db/nudb";
-    os_.sethostname(hostname);
+    argparse::ArgumentParser program{"xrplorer", "0.1.0"};
+    program.add_argument("hostname")
+        .help("path to the node store, or to a snapshot file")
+        // Copy the default nodestore path from the example rippled.cfg.
+        .default_value(std::string{"/var/lib/rippled/db/nudb"})
+        .nargs(argparse::nargs_pattern::optional);
+    program.add_argument("--json")
+        .help("print listings and file contents as JSON")
+        .flag();
+    DatabaseOptions defaults;
+    program.add_argument("--job-threads")
+        .help("threads in the job queue")
+        .default_value(defaults.jobThreads)
+        .scan<'i', int>();
+    program.add_argument("--read-threads")
+        .help("threads serving asynchronous reads in the node store")
+        .default_value(defaults.readThreads)
+        .scan<'i', int>();
+    program.add_argument("--burst-size")
+        .help("node store burst size, in MiB")
+        .default_value(static_cast<int>(defaults.burstSize / ripple::megabytes(1)))
+        .scan<'i', int>();
+    program.add_argument("--walkers")
+        .help("maximum concurrent fetches in parallel walks")
+        .default_value(static_cast<int>(defaults.walkers))
+        .scan<'i', int>();
+    program.add_argument("--adaptive")
+        .help("scale concurrent fetches with the observed fetch latency")
+        .flag();
+    program.add_argument("--cache-size")
+        .help(fmt::format(
+            "node objects to keep in memory after they are fetched (default {} with --serve)",
+            SERVE_CACHE_SIZE))
+        .default_value(defaults.cacheSize)
+        .scan<'i', int>();
+    program.add_argument("--cache-age")
+        .help(fmt::format(
+            "minutes to keep a cached node object after its last fetch (default {} with --serve)",
+            SERVE_CACHE_AGE))
+        .default_value(defaults.cacheAge)
+        .scan<'i', int>();
+    program.add_argument("--serve")
+        .help("serve sessions on a Unix domain socket at this path");
+    program.add_argument("--connect")
+        .help("run commands on the server at this socket path");
+    program.add_argument("--threads")
+        .help("threads running commands for sessions when serving")
+        .default_value(static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u)))
+        .scan<'i', int>();
+    try {
+        program.parse_args(argc, argv);
+    } catch (std::exception const& ex) {
+        fmt::print(stderr, "{}\n{}", ex.what(), program.help().str());
+        return 1;
+    }
+    // Negative counts would wrap around when cast to unsigned.
+    if (program.get<int>("--walkers") < 1) {
+        fmt::print(stderr, "--walkers must be at least 1\n{}", program.help().str());
+        return 1;
+    }
+    if (program.get<bool>("--json")) {
+        os_.setenv("FORMAT", "json");
+    }
+    if (auto path = program.present("--connect")) {
+        return connect(*path);
+    }
+    DatabaseOptions options;
+    options.jobThreads = program.get<int>("--job-threads");
+    options.readThreads = program.get<int>("--read-threads");
+    options.burstSize = ripple::megabytes(
+        static_cast<std::size_t>(program.get<int>("--burst-size")));
+    options.walkers = static_cast<unsigned int>(program.get<int>("--walkers"));
+    options.adaptive = program.get<bool>("--adaptive");
+    options.cacheSize = program.get<int>("--cache-size");
+    options.cacheAge = program.get<int>("--cache-age");
+    if (program.present("--serve")) {
+        if (!program.is_used("--cache-size")) {
+            options.cacheSize = SERVE_CACHE_SIZE;
+        }
+        if (!program.is_used("--cache-age")) {
+            options.cacheAge = SERVE_CACHE_AGE;
+        }
+    }
+    os_.setdboptions(options);
+    auto hostname = program.get<std::string>("hostname");
+    try {
+        os_.sethostname(hostname);
+    } catch (Exception const& ex) {
+        fmt::print(stderr, "{}: {}\n", ex.path, ex.message);
+        return ex.code;
+    }
 
-    namespace po = boost::program_options;
-    LineReader lineReader;
-    while (auto line = lineReader.readline("> ")) {
-        std::string cmdline{line};
+    if (auto path = program.present("--serve")) {
+        auto threads = static_cast<unsigned int>(program.get<int>("--threads"));
+        try {
+            Server{os_, *path, threads}.run();
+        } catch (std::exception const& ex) {
+            fmt::print(stderr, "{}: {}\n", *path, ex.what());
+            return 1;
+        }
+        return 0;
+    }
 
-        auto strings = po::split_unix(cmdline);
-        int argc = strings.size();
-        if (argc < 1) {
-            continue;
+    LineReader lineReader;
+    while (true) {
+        // Output is buffered. Flush it before waiting on the next command.
+        std::fflush(os_.stdout);
+        auto line = lineReader.readline("> ");
+        if (!line) {
+            break;
         }
-        std::vector<char*> pointers;
-        pointers.reserve(argc);
-        for (auto& string : strings) {
-            pointers.push_back(string.data());
+        if (auto status = execute(line)) {
+            return *status;
         }
-        char** argv = pointers.data();
+    }
+    return 0;
+}
 
-        std::string command = argv[0];
-        if (command == "exit") {
-            return this->exit(argc, argv);
-        }
-        if (command == "cd") {
-            this->cd(argc, argv);
-            continue;
+std::optional<int> Shell::execute(std::string const& cmdline) {
+    namespace po = boost::program_options;
+    auto strings = po::split_unix(cmdline);
+    int argc = strings.size();
+    if (argc < 1) {
+        return std::nullopt;
+    }
+    std::vector<char*> pointers;
+    pointers.reserve(argc);
+    for (auto& string : strings) {
+        pointers.push_back(string.data());
+    }
+    char** argv = pointers.data();
+
+    std::string command = argv[0];
+    if (command == "exit") {
+        return this->exit(argc, argv);
+    }
+    if (command == "bench") {
+        this->bench(argc, argv);
+        return std::nullopt;
+    }
+    if (command == "cd") {
+        this->cd(argc, argv);
+        return std::nullopt;
+    }
+    if (command == "echo") {
+        this->echo(argc, argv);
+        return std::nullopt;
+    }
+    if (command == "export") {
+        this->export_(argc, argv);
+        return std::nullopt;
+    }
+    if (command == "pwd") {
+        this->pwd(argc, argv);
+        return std::nullopt;
+    }
+
+    if (command == "cat") {
+        this->cat(argc, argv);
+        return std::nullopt;
+    }
+    if (command == "exists") {
+        this->exists(argc, argv);
+        return std::nullopt;
+    }
+    if (command == "extract-txns") {
+        this->extractTxns(argc, argv);
+        return std::nullopt;
+    }
+    if (command == "help") {
+        this->help(argc, argv);
+        return std::nullopt;
+    }
+    if (command == "history") {
+        this->history(argc, argv);
+        return std::nullopt;
+    }
+    if (command == "hostname") {
+        this->hostname(argc, argv);
+        return std::nullopt;
+    }
+    if (command == "ls") {
+        this->ls(argc, argv);
+        return std::nullopt;
+    }
+    if (command == "materialize") {
+        this->materialize(argc, argv);
+        return std::nullopt;
+    }
+    if (command == "orphans") {
+        this->orphans(argc, argv);
+        return std::nullopt;
+    }
+    if (command == "proof") {
+        this->proof(argc, argv);
+        return std::nullopt;
+    }
+    if (command == "replay") {
+        this->replay(argc, argv);
+        return std::nullopt;
+    }
+    if (command == "retention") {
+        this->retention(argc, argv);
+        return std::nullopt;
+    }
+    if (command == "scan") {
+        this->scan(argc, argv);
+        return std::nullopt;
+    }
+    if (command == "select") {
+        this->select(argc, argv);
+        return std::nullopt;
+    }
+    if (command == "snapshot") {
+        this->snapshot(argc, argv);
+        return std::nullopt;
+    }
+    if (command == "stat") {
+        this->stat(argc, argv);
+        return std::nullopt;
+    }
+    if (command == "trace") {
+        this->trace(argc, argv);
+        return std::nullopt;
+    }
+    if (command == "unset") {
+        this->unset(argc, argv);
+        return std::nullopt;
+    }
+    fmt::print(os_.stdout, "{}: command not found\n", argv[0]);
+    return std::nullopt;
+}
+
+int Shell::connect(std::string const& path) {
+    namespace po = boost::program_options;
+    std::optional<Client> client;
+    try {
+        client.emplace(path);
+    } catch (std::exception const& ex) {
+        fmt::print(stderr, "{}: {}\n", path, ex.what());
+        return 1;
+    }
+    // The session on the server starts with an empty environment.
+    if (os_.getenv("FORMAT") == "json") {
+        client->request("export FORMAT=json");
+    }
+    LineReader lineReader;
+    while (true) {
+        std::fflush(os_.stdout);
+        auto line = lineReader.readline("> ");
+        if (!line) {
+            break;
         }
-        if (command == "echo") {
-            this->echo(argc, argv);
-            continue;
+        auto output = client->request(line);
+        if (!output) {
+            fmt::print(stderr, "{}: connection closed\n", path);
+            return 1;
         }
-        if (command == "pwd") {
-            this->pwd(argc, argv);
-            continue;
+        std::fwrite(output->data(), 1, output->size(), os_.stdout);
+        // The server ends the session after `exit`.
+        auto strings = po::split_unix(line);
+        if (!strings.empty() && strings.front() == "exit") {
+            break;
         }
+    }
+    return 0;
+}
 
-        if (command == "cat") {
-            this->cat(argc, argv);
-            continue;
+NodePtr resolveLedger(OperatingSystem& os, std::string_view argument) {
+    auto object = command(os, argument, Action::RESOLVE).node;
+    if (!object || ripple::deserializePrefix(object) != ripple::HashPrefix::ledgerMaster) {
+        throw Exception{NOT_A_LEDGER, std::string{argument}, "not a ledger"};
+    }
+    return object;
+}
+
+/**
+ * Resolve a path to the root of a tree:
+ * the state tree of a ledger, or the subtree under an inner node.
+ */
+ripple::uint256 resolveTree(OperatingSystem& os, std::string_view argument) {
+    auto object = command(os, argument, Action::RESOLVE).node;
+    if (object) {
+        auto prefix = ripple::deserializePrefix(object);
+        if (prefix == ripple::HashPrefix::ledgerMaster) {
+            return ripple::deserializePrefixedHeader(object).accountHash;
         }
-        if (command == "help") {
-            this->help(argc, argv);
-            continue;
+        if (prefix == ripple::HashPrefix::innerNode) {
+            return object->getHash();
         }
-        if (command == "hostname") {
-            this->hostname(argc, argv);
-            continue;
+    }
+    throw Exception{NOT_A_DIRECTORY, std::string{argument}, "not a tree"};
+}
+
+struct FieldChange {
+    std::string name;
+    // Null when the field is absent.
+    ripple::STBase const* before;
+    ripple::STBase const* after;
+};
+
+static bool isEmpty(ripple::STBase const& field) {
+    return field.isDefault() && field.getText() == "";
+}
+
+static std::vector<FieldChange> diff(ripple::SLE const* before, ripple::SLE const* after) {
+    std::vector<FieldChange> changes;
+    if (after) {
+        for (auto const& field : *after) {
+            if (isEmpty(field)) {
+                continue;
+            }
+            auto const* old = (before && before->isFieldPresent(field.getFName()))
+                ? before->peekAtPField(field.getFName())
+                : nullptr;
+            if (old && *old == field) {
+                continue;
+            }
+            changes.push_back({field.getFName().getName(), old, &field});
         }
-        if (command == "ls") {
-            this->ls(argc, argv);
-            continue;
+    }
+    if (before) {
+        for (auto const& field : *before) {
+            if (isEmpty(field) || (after && after->isFieldPresent(field.getFName()))) {
+                continue;
+            }
+            changes.push_back({field.getFName().getName(), &field, nullptr});
         }
-        fmt::print(os_.stdout, "{}: command not found\n", argv[0]);
     }
-    return 0;
+    return changes;
 }
 
-void command(OperatingSystem& os, std::string_view argument, Action action) {
-    auto path = (os.getcwd() / argument).lexically_normal();
-    auto it = path.begin();
-    assert(*it == "/");
-    ++it;
-    Context ctx {
-        .os = os,
-        .argument = argument,
-        .path = path,
-        .it = std::move(it),
-        .action = action,
-    };
-    RootDirectory::call(ctx);
+static void printChange(
+    FILE* out,
+    bool json,
+    std::uint32_t seq,
+    std::string_view label,
+    NodePtr const& before,
+    NodePtr const& after)
+{
+    std::optional<ripple::SLE> sleBefore, sleAfter;
+    if (before) {
+        sleBefore.emplace(splitLeaf(before)->sle());
+    }
+    if (after) {
+        sleAfter.emplace(splitLeaf(after)->sle());
+    }
+    auto changes = diff(
+        sleBefore ? &*sleBefore : nullptr, sleAfter ? &*sleAfter : nullptr);
+    if (json) {
+        Json::Value value{Json::objectValue};
+        value["ledger_index"] = seq;
+        value["label"] = std::string{label};
+        Json::Value fields{Json::arrayValue};
+        for (auto const& change : changes) {
+            Json::Value field{Json::objectValue};
+            field["field"] = change.name;
+            field["before"] = change.before
+                ? change.before->getJson(ripple::JsonOptions::none)
+                : Json::Value{};
+            field["after"] = change.after
+                ? change.after->getJson(ripple::JsonOptions::none)
+                : Json::Value{};
+            fields.append(field);
+        }
+        value["changes"] = fields;
+        return printJson(out, value);
+    }
+    fmt::print(out, "ledger {} ({})\n", seq, label);
+    if (before && !after) {
+        fmt::print(out, "    deleted\n");
+    }
+    if (!before && after && label != "initial") {
+        fmt::print(out, "    created\n");
+    }
+    for (auto const& change : changes) {
+        fmt::print(out, "    {}: {} -> {}\n",
+            change.name,
+            change.before ? change.before->getText() : "",
+            change.after ? change.after->getText() : "");
+    }
+}
+
+/** Parse a decimal number that fits in 32 bits, with nothing after it. */
+static std::optional<std::uint32_t> parseUint32(std::string_view token) {
+    std::uint32_t value;
+    auto end = token.data() + token.size();
+    auto [ptr, ec] = std::from_chars(token.data(), end, value);
+    if (ec != std::errc{} || ptr != end) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+int Shell::bench(int argc, char** argv) {
+    assert(argv[0] == "bench"sv);
+    if (argc < 2) {
+        fmt::print(os_.stdout, "{}: usage: bench digest [walkers ...]\n", argv[0]);
+        return 2;
+    }
+    ripple::uint256 root;
+    if (!root.parseHex(argv[1])) {
+        fmt::print(os_.stdout, "{}: {}: not a digest\n", argv[0], argv[1]);
+        return NOT_A_DIGEST;
+    }
+    // Without a count, use the configured (possibly adaptive) limit.
+    std::vector<std::optional<unsigned int>> runs;
+    for (auto i = 2; i < argc; ++i) {
+        auto count = parseUint32(argv[i]);
+        if (!count) {
+            fmt::print(os_.stdout, "{}: {}: numeric argument required\n", argv[0], argv[i]);
+            return 2;
+        }
+        runs.push_back(*count);
+    }
+    if (runs.empty()) {
+        runs.push_back(std::nullopt);
+    }
+    auto& db = os_.db();
+    fmt::print(os_.stdout, "{:>8} {:>10} {:>10} {:>8} {:>10} {:>8} {:>10}\n",
+        "walkers", "nodes", "MiB", "seconds", "nodes/s", "MiB/s", "latency/us");
+    for (auto const& walkers : runs) {
+        auto before = db.stats();
+        auto start = std::chrono::steady_clock::now();
+        auto n = walk(db, {root}, [](auto&&...) { return true; }, walkers);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        auto after = db.stats();
+        auto nodes = after.fetches - before.fetches;
+        auto mebibytes = static_cast<double>(after.bytes - before.bytes) / ripple::megabytes(1);
+        auto seconds = elapsed.count();
+        auto latency = nodes ? (after.nanos - before.nanos) / 1000.0 / nodes : 0.0;
+        // An adaptive run shows the limit where it settled.
+        auto label = (walkers || !db.options_.adaptive)
+            ? fmt::format("{}", n)
+            : fmt::format("~{}", db.concurrency());
+        fmt::print(os_.stdout, "{:>8} {:>10} {:>10.1f} {:>8.2f} {:>10.0f} {:>8.1f} {:>10.1f}\n",
+            label, nodes, mebibytes, seconds, nodes / seconds, mebibytes / seconds, latency);
+        std::fflush(os_.stdout);
+    }
+    return 0;
 }
 
 int Shell::cat(int argc, char** argv) {
@@ -156,6 +559,20 @@ int Shell::echo(int argc, char** argv) {
     return 0;
 }
 
+int Shell::export_(int argc, char** argv) {
+    assert(argv[0] == "export"sv);
+    for (auto i = 1; i < argc; ++i) {
+        std::string_view assignment{argv[i]};
+        auto equals = assignment.find('=');
+        if (equals == std::string_view::npos) {
+            fmt::print(os_.stdout, "{}: {}: expected NAME=VALUE\n", argv[0], assignment);
+            return 1;
+        }
+        os_.setenv(assignment.substr(0, equals), assignment.substr(equals + 1));
+    }
+    return 0;
+}
+
 int Shell::exit(int argc, char** argv) {
     assert(argv[0] == "exit"sv);
     if (argc == 1) {
@@ -173,22 +590,230 @@ int Shell::exit(int argc, char** argv) {
     return 1;
 }
 
+int Shell::exists(int argc, char** argv) {
+    assert(argv[0] == "exists"sv);
+    // With `-f`, build (once) and consult a Bloom filter of the key file.
+    auto filter = argc > 1 && argv[1] == "-f"sv;
+    auto first = filter ? 2 : 1;
+    if (argc <= first) {
+        fmt::print(os_.stdout, "{}: usage: exists [-f] digest|@file ...\n", argv[0]);
+        return 2;
+    }
+    std::vector<ripple::uint256> digests;
+    auto parse = [&](std::string_view text) {
+        if (!digests.emplace_back().parseHex(text)) {
+            fmt::print(os_.stdout, "{}: {}: not a digest\n", argv[0], text);
+            return false;
+        }
+        return true;
+    };
+    for (auto i = first; i < argc; ++i) {
+        if (argv[i][0] != '@') {
+            if (!parse(argv[i])) {
+                return NOT_A_DIGEST;
+            }
+            continue;
+        }
+        // One digest per line.
+        std::ifstream in{argv[i] + 1};
+        if (!in) {
+            fmt::print(os_.stdout, "{}: {}: cannot open for reading\n", argv[0], argv[i] + 1);
+            return DOES_NOT_EXIST;
+        }
+        for (std::string line; std::getline(in, line);) {
+            if (!line.empty() && !parse(line)) {
+                return NOT_A_DIGEST;
+            }
+        }
+    }
+    ExistsStats stats;
+    std::vector<bool> present;
+    auto start = std::chrono::steady_clock::now();
+    try {
+        auto index = openKeyIndex(os_.db(), os_.gethostname(), filter);
+        present = index->contains(digests, stats, countWalkers(os_.db()));
+    } catch (Exception const& ex) {
+        fmt::print(os_.stdout, "{}: {}: {}\n", argv[0], ex.path, ex.message);
+        return ex.code;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    // Print the digests that are absent.
+    if (os_.getenv("FORMAT") == "json") {
+        Json::Value value{Json::objectValue};
+        Json::Value absent{Json::arrayValue};
+        for (std::size_t i = 0; i < digests.size(); ++i) {
+            if (!present[i]) {
+                absent.append(to_string(digests[i]));
+            }
+        }
+        value["queries"] = std::to_string(stats.queries);
+        value["present"] = std::to_string(stats.present);
+        value["filtered"] = std::to_string(stats.filtered);
+        value["absent"] = absent;
+        printJson(os_.stdout, value);
+        return 0;
+    }
+    for (std::size_t i = 0; i < digests.size(); ++i) {
+        if (!present[i]) {
+            fmt::print(os_.stdout, "{}\n", digests[i]);
+        }
+    }
+    fmt::print(os_.stdout, "# {} of {} present, {} answered by the filter, {} buckets ({} spills) read in {:.2f} s\n",
+        stats.present, stats.queries, stats.filtered, stats.buckets, stats.spills, elapsed.count());
+    return 0;
+}
+
+int Shell::extractTxns(int argc, char** argv) {
+    assert(argv[0] == "extract-txns"sv);
+    if (argc < 4 || argc > 5) {
+        fmt::print(os_.stdout, "{}: usage: extract-txns from to file [ledger]\n", argv[0]);
+        return 2;
+    }
+    auto first = parseUint32(argv[1]);
+    auto last = parseUint32(argv[2]);
+    if (!first || !last) {
+        fmt::print(os_.stdout, "{}: numeric argument required\n", argv[0]);
+        return 2;
+    }
+    auto from = *first;
+    auto to = *last;
+    if (from > to) {
+        fmt::print(os_.stdout, "{}: {} > {}\n", argv[0], from, to);
+        return 2;
+    }
+    auto format = (os_.getenv("FORMAT") == "json") ? StreamFormat::NDJSON : StreamFormat::BINARY;
+    // `-` streams to standard output.
+    auto toStdout = argv[3] == "-"sv;
+    auto* out = toStdout ? os_.stdout : std::fopen(argv[3], "wb");
+    if (!out) {
+        fmt::print(os_.stdout, "{}: {}: cannot open for writing\n", argv[0], argv[3]);
+        return WRITE_FAILED;
+    }
+    if (!toStdout) {
+        std::setvbuf(out, nullptr, _IOFBF, ripple::megabytes(1));
+    }
+    ExtractStats stats;
+    auto start = std::chrono::steady_clock::now();
+    auto code = 0;
+    try {
+        auto anchor = resolveLedger(os_, (argc > 4) ? argv[4] : ".");
+        stats = extractTransactions(os_.db(), anchor, from, to, out, format);
+    } catch (Exception const& ex) {
+        auto path = (ex.code == WRITE_FAILED) ? std::filesystem::path{argv[3]} : ex.path;
+        fmt::print(os_.stdout, "{}: {}: {}\n", argv[0], path, ex.message);
+        code = ex.code;
+    }
+    if (!toStdout && std::fclose(out) != 0 && code == 0) {
+        fmt::print(os_.stdout, "{}: {}: write failed\n", argv[0], argv[3]);
+        return WRITE_FAILED;
+    }
+    if (code != 0 || toStdout) {
+        return code;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    fmt::print(os_.stdout, "# {} transactions from {} ledgers, {:.1f} MiB in {:.2f} s\n",
+        stats.transactions, stats.ledgers,
+        static_cast<double>(stats.bytes) / ripple::megabytes(1), elapsed.count());
+    return 0;
+}
+
 int Shell::help(int argc, char** argv) {
+    fmt::print(os_.stdout, "bench digest [walkers ...]\n");
     fmt::print(os_.stdout, "cat [file]\n");
     fmt::print(os_.stdout, "cd [dir]\n");
     fmt::print(os_.stdout, "echo [arg ...]\n");
     fmt::print(os_.stdout, "exit [n]\n");
+    fmt::print(os_.stdout, "export [name=value ...]\n");
+    fmt::print(os_.stdout, "exists [-f] digest|@file ...\n");
+    fmt::print(os_.stdout, "extract-txns from to file [ledger]\n");
     fmt::print(os_.stdout, "help\n");
+    fmt::print(os_.stdout, "history address from to [ledger]\n");
     fmt::print(os_.stdout, "hostname [name]\n");
     fmt::print(os_.stdout, "ls [dir]\n");
+    fmt::print(os_.stdout, "materialize [ledger]\n");
+    fmt::print(os_.stdout, "orphans [-l] from to [ledger]\n");
+    fmt::print(os_.stdout, "proof key ... [from tree]\n");
     fmt::print(os_.stdout, "pwd\n");
+    fmt::print(os_.stdout, "replay file [threads [cache-size [store]]]\n");
+    fmt::print(os_.stdout, "retention from to [ledger]\n");
+    fmt::print(os_.stdout, "scan [workers]\n");
+    fmt::print(os_.stdout, "select predicate [from tree]\n");
+    fmt::print(os_.stdout, "snapshot ledger file\n");
+    fmt::print(os_.stdout, "stat [ledger|inner node]\n");
+    fmt::print(os_.stdout, "trace [file]\n");
+    fmt::print(os_.stdout, "unset [name ...]\n");
+    fmt::print(os_.stdout, "\n");
+    fmt::print(os_.stdout, "FORMAT=json prints listings and file contents as JSON.\n");
+    fmt::print(os_.stdout, "Paths may contain globs (*, ?, [...]), whose matches are followed in parallel.\n");
+    return 0;
+}
+
+int Shell::history(int argc, char** argv) {
+    assert(argv[0] == "history"sv);
+    if (argc < 4 || argc > 5) {
+        fmt::print(os_.stdout, "{}: usage: history address from to [ledger]\n", argv[0]);
+        return 2;
+    }
+    auto accountId = ripple::parseBase58<ripple::AccountID>(argv[1]);
+    if (!accountId) {
+        fmt::print(os_.stdout, "{}: {}: not an address\n", argv[0], argv[1]);
+        return 2;
+    }
+    auto first = parseUint32(argv[2]);
+    auto last = parseUint32(argv[3]);
+    if (!first || !last) {
+        fmt::print(os_.stdout, "{}: numeric argument required\n", argv[0]);
+        return 2;
+    }
+    auto from = *first;
+    auto to = *last;
+    if (from > to) {
+        fmt::print(os_.stdout, "{}: {} > {}\n", argv[0], from, to);
+        return 2;
+    }
+    auto json = os_.getenv("FORMAT") == "json";
+    try {
+        // The ledger to start from, whose ancestors include `to`.
+        auto anchor = resolveLedger(os_, (argc > 4) ? argv[4] : ".");
+        auto keylet = ripple::keylet::account(*accountId);
+        // Changes come newest first.
+        auto history = entryHistory(os_.db(), anchor, keylet.key, from, to,
+            [&](EntryChange const& change) {
+                auto closeTime = ripple::to_string(change.header.closeTime);
+                printChange(os_.stdout, json, change.header.seq, closeTime,
+                    change.before, change.after);
+                return true;
+            });
+        if (history.initial) {
+            printChange(os_.stdout, json, from, "initial", nullptr, history.initial);
+        }
+        if (!json) {
+            fmt::print(os_.stdout, "# {} ledgers compared, {} unchanged by digest\n",
+                history.ledgers, history.unchanged);
+        }
+    } catch (Exception const& ex) {
+        fmt::print(os_.stdout, "{}: {}: {}\n", argv[0], ex.path, ex.message);
+        return ex.code;
+    }
     return 0;
 }
 
 int Shell::hostname(int argc, char** argv) {
     assert(argv[0] == "hostname"sv);
+    if (argc > 2) {
+        fmt::print(os_.stdout, "{}: too many arguments\n", argv[0]);
+        return 1;
+    }
     if (argc > 1) {
-        fmt::print(os_.stdout, "{}: changing hostname not yet implemented\n", argv[0]);
+        try {
+            os_.sethostname(argv[1]);
+        } catch (Exception const& ex) {
+            fmt::print(os_.stdout, "{}: {}: {}\n", argv[0], ex.path, ex.message);
+            return ex.code;
+        } catch (std::exception const& ex) {
+            fmt::print(os_.stdout, "{}: {}: {}\n", argv[0], argv[1], ex.what());
+            return 1;
+        }
     }
     auto sv = os_.gethostname();
     fmt::print(os_.stdout, "{}\n", sv);
@@ -215,6 +840,167 @@ int Shell::ls(int argc, char** argv_) {
     return 0;
 }
 
+int Shell::materialize(int argc, char** argv) {
+    assert(argv[0] == "materialize"sv);
+    if (argc > 2) {
+        fmt::print(os_.stdout, "{}: too many arguments\n", argv[0]);
+        return 1;
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::shared_ptr<MaterializedState const> state;
+    try {
+        auto root = resolveTree(os_, (argc > 1) ? argv[1] : ".");
+        state = xrplorer::materialize(os_.db(), root);
+    } catch (Exception const& ex) {
+        fmt::print(os_.stdout, "{}: {}: {}\n", argv[0], ex.path, ex.message);
+        return ex.code;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    fmt::print(os_.stdout, "# {} entries under {}, {:.1f} MiB in {:.2f} s\n",
+        state->size(), state->root,
+        static_cast<double>(state->bytes()) / ripple::megabytes(1), elapsed.count());
+    return 0;
+}
+
+int Shell::orphans(int argc, char** argv) {
+    assert(argv[0] == "orphans"sv);
+    auto list = argc > 1 && argv[1] == "-l"sv;
+    auto args = list ? argv + 1 : argv;
+    auto nargs = list ? argc - 1 : argc;
+    if (nargs < 3 || nargs > 4) {
+        fmt::print(os_.stdout, "{}: usage: orphans [-l] from to [ledger]\n", argv[0]);
+        return 2;
+    }
+    auto first = parseUint32(args[1]);
+    auto last = parseUint32(args[2]);
+    if (!first || !last) {
+        fmt::print(os_.stdout, "{}: numeric argument required\n", argv[0]);
+        return 2;
+    }
+    auto from = *first;
+    auto to = *last;
+    if (from > to) {
+        fmt::print(os_.stdout, "{}: {} > {}\n", argv[0], from, to);
+        return 2;
+    }
+    auto& db = os_.db();
+    using Orphan = std::pair<ripple::uint256, std::size_t>;
+    std::vector<std::vector<Orphan>> partials(countWalkers(db));
+    OrphanVisitor visitor;
+    if (list) {
+        visitor = [&](unsigned int worker, ripple::uint256 const& digest, std::size_t stored) {
+            partials[worker].emplace_back(digest, stored);
+        };
+    }
+    OrphanTotals totals;
+    auto start = std::chrono::steady_clock::now();
+    try {
+        auto anchor = resolveLedger(os_, (nargs > 3) ? args[3] : ".");
+        totals = findOrphans(db, os_.gethostname(), anchor, from, to, visitor);
+    } catch (Exception const& ex) {
+        fmt::print(os_.stdout, "{}: {}: {}\n", argv[0], ex.path, ex.message);
+        return ex.code;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::vector<Orphan> orphans;
+    for (auto& partial : partials) {
+        orphans.insert(orphans.end(), partial.begin(), partial.end());
+    }
+    std::sort(orphans.begin(), orphans.end());
+    auto mebibytes = [](std::uint64_t bytes) {
+        return static_cast<double>(bytes) / ripple::megabytes(1);
+    };
+    if (os_.getenv("FORMAT") == "json") {
+        Json::Value value{Json::objectValue};
+        value["reachable"] = std::to_string(totals.reachable);
+        value["missing"] = std::to_string(totals.missing);
+        value["records"] = std::to_string(totals.scan.records);
+        value["corrupt"] = std::to_string(totals.scan.corrupt);
+        value["orphans"] = std::to_string(totals.orphans);
+        value["orphan_bytes"] = std::to_string(totals.orphanBytes);
+        value["seconds"] = elapsed.count();
+        if (list) {
+            Json::Value digests{Json::arrayValue};
+            for (auto const& [digest, stored] : orphans) {
+                digests.append(fmt::format("{}", digest));
+            }
+            value["digests"] = digests;
+        }
+        printJson(os_.stdout, value);
+        return 0;
+    }
+    for (auto const& [digest, stored] : orphans) {
+        fmt::print(os_.stdout, "{} {:>8}\n", digest, stored);
+    }
+    fmt::print(os_.stdout, "# {} reachable ({} missing), {} of {} records orphaned ({:.1f} MiB) in {:.2f} s\n",
+        totals.reachable, totals.missing, totals.orphans, totals.scan.records,
+        mebibytes(totals.orphanBytes), elapsed.count());
+    return 0;
+}
+
+int Shell::proof(int argc, char** argv) {
+    assert(argv[0] == "proof"sv);
+    // The keys are every argument before an optional `from tree`.
+    char const* tree = ".";
+    auto end = argc;
+    if (argc > 2 && argv[argc - 2] == "from"sv) {
+        tree = argv[argc - 1];
+        end = argc - 2;
+    }
+    if (end < 2) {
+        fmt::print(os_.stdout, "{}: usage: proof key ... [from tree]\n", argv[0]);
+        return 2;
+    }
+    std::vector<ripple::uint256> keys;
+    for (auto i = 1; i < end; ++i) {
+        if (!keys.emplace_back().parseHex(argv[i])) {
+            fmt::print(os_.stdout, "{}: {}: not a key\n", argv[0], argv[i]);
+            return 2;
+        }
+    }
+    auto json = os_.getenv("FORMAT") == "json";
+    try {
+        auto root = resolveTree(os_, tree);
+        auto batch = prove(os_.db(), root, std::move(keys));
+        for (auto const& proof : batch.proofs) {
+            if (json) {
+                Json::Value value{Json::objectValue};
+                value["key"] = to_string(proof.key);
+                value["root"] = to_string(root);
+                value["included"] = proof.included();
+                if (proof.leaf) {
+                    value["leaf"] = ripple::strHex(proof.leaf->getData());
+                }
+                Json::Value path{Json::arrayValue};
+                for (auto const& level : proof.path) {
+                    Json::Value branches{Json::arrayValue};
+                    for (auto const& branch : level.branches) {
+                        branches.append(to_string(branch));
+                    }
+                    path.append(branches);
+                }
+                value["path"] = path;
+                printJson(os_.stdout, value);
+                continue;
+            }
+            fmt::print(os_.stdout, "{} {}\n", proof.key, proof.included() ? "included" : "absent");
+            for (auto const& level : proof.path) {
+                fmt::print(os_.stdout, "  {}\n", level.digest);
+            }
+            if (proof.leaf) {
+                fmt::print(os_.stdout, "  {}\n", proof.leaf->getHash());
+            }
+        }
+        if (!json) {
+            fmt::print(os_.stdout, "# {} proofs from {} fetches\n", batch.proofs.size(), batch.fetches);
+        }
+    } catch (Exception const& ex) {
+        fmt::print(os_.stdout, "{}: {}: {}\n", argv[0], ex.path, ex.message);
+        return ex.code;
+    }
+    return 0;
+}
+
 int Shell::pwd(int argc, char** argv) {
     assert(argv[0] == "pwd"sv);
     auto const& path = os_.getcwd();
@@ -222,4 +1008,440 @@ int Shell::pwd(int argc, char** argv) {
     return 0;
 }
 
+static std::string typeLabel(std::uint32_t type) {
+    if (type > 0xFFFF) {
+        return ripple::format_as(static_cast<ripple::HashPrefix>(type));
+    }
+    auto let = static_cast<ripple::LedgerEntryType>(type);
+    auto name = typeName(let);
+    return name.empty() ? ripple::format_as(let) : std::string{name};
+}
+
+static std::string sizeRange(unsigned int bucket) {
+    if (bucket == 0) {
+        return "0";
+    }
+    return fmt::format("[{}, {})", std::uint64_t{1} << (bucket - 1), std::uint64_t{1} << bucket);
+}
+
+int Shell::replay(int argc, char** argv) {
+    assert(argv[0] == "replay"sv);
+    if (argc < 2 || argc > 5) {
+        fmt::print(os_.stdout, "{}: usage: replay file [threads [cache-size [store]]]\n", argv[0]);
+        return 2;
+    }
+    auto options = os_.getdboptions();
+    unsigned int threads = options.walkers;
+    if (argc > 2) {
+        auto count = parseUint32(argv[2]);
+        if (!count) {
+            fmt::print(os_.stdout, "{}: {}: numeric argument required\n", argv[0], argv[2]);
+            return 2;
+        }
+        threads = *count;
+    }
+    if (argc > 3) {
+        auto count = parseUint32(argv[3]);
+        if (!count || *count > static_cast<std::uint32_t>(std::numeric_limits<int>::max())) {
+            fmt::print(os_.stdout, "{}: {}: numeric argument required\n", argv[0], argv[3]);
+            return 2;
+        }
+        options.cacheSize = static_cast<int>(*count);
+    }
+    // A NuDB store or a snapshot, by default the one that is open.
+    std::string store{(argc > 4) ? std::string_view{argv[4]} : os_.gethostname()};
+    std::vector<TraceRecord> trace;
+    try {
+        trace = readTrace(argv[1]);
+    } catch (Exception const& ex) {
+        fmt::print(os_.stdout, "{}: {}: {}\n", argv[0], ex.path, ex.message);
+        return ex.code;
+    }
+    std::vector<std::uint32_t> recorded;
+    recorded.reserve(trace.size());
+    for (auto const& record : trace) {
+        recorded.push_back(record.latency);
+    }
+    std::sort(recorded.begin(), recorded.end());
+    ReplayStats stats;
+    try {
+        // A store of its own, so that it starts with a cold cache.
+        Database db{store, options};
+        stats = replayTrace(db, trace, threads);
+    } catch (Exception const& ex) {
+        fmt::print(os_.stdout, "{}: {}: {}\n", argv[0], ex.path, ex.message);
+        return ex.code;
+    } catch (std::exception const& ex) {
+        fmt::print(os_.stdout, "{}: {}: {}\n", argv[0], store, ex.what());
+        return 1;
+    }
+    auto micros = [](std::uint32_t nanos) {
+        return static_cast<double>(nanos) / 1000;
+    };
+    if (os_.getenv("FORMAT") == "json") {
+        auto quantiles = [&](std::vector<std::uint32_t> const& latencies) {
+            Json::Value value{Json::objectValue};
+            value["p50"] = percentile(latencies, 0.5);
+            value["p90"] = percentile(latencies, 0.9);
+            value["p99"] = percentile(latencies, 0.99);
+            value["p999"] = percentile(latencies, 0.999);
+            value["max"] = percentile(latencies, 1);
+            return value;
+        };
+        Json::Value value{Json::objectValue};
+        value["fetches"] = std::to_string(stats.fetches);
+        value["misses"] = std::to_string(stats.misses);
+        value["bytes"] = std::to_string(stats.bytes);
+        value["threads"] = threads;
+        value["seconds"] = stats.seconds;
+        value["recorded_nanos"] = quantiles(recorded);
+        value["replayed_nanos"] = quantiles(stats.latencies);
+        printJson(os_.stdout, value);
+        return 0;
+    }
+    fmt::print(os_.stdout, "{:<10} {:>10} {:>10} {:>10} {:>10} {:>10}\n",
+        "us", "p50", "p90", "p99", "p99.9", "max");
+    for (auto const& [name, latencies] : {
+        std::pair{"recorded", &recorded}, std::pair{"replayed", &stats.latencies}})
+    {
+        fmt::print(os_.stdout, "{:<10} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f}\n",
+            name,
+            micros(percentile(*latencies, 0.5)), micros(percentile(*latencies, 0.9)),
+            micros(percentile(*latencies, 0.99)), micros(percentile(*latencies, 0.999)),
+            micros(percentile(*latencies, 1)));
+    }
+    fmt::print(os_.stdout, "# {} fetches ({} misses) with {} threads in {:.2f} s, {:.0f} fetches/s\n",
+        stats.fetches, stats.misses, threads, stats.seconds, stats.fetches / stats.seconds);
+    return 0;
+}
+
+int Shell::retention(int argc, char** argv) {
+    assert(argv[0] == "retention"sv);
+    if (argc < 3 || argc > 4) {
+        fmt::print(os_.stdout, "{}: usage: retention from to [ledger]\n", argv[0]);
+        return 2;
+    }
+    auto first = parseUint32(argv[1]);
+    auto last = parseUint32(argv[2]);
+    if (!first || !last) {
+        fmt::print(os_.stdout, "{}: numeric argument required\n", argv[0]);
+        return 2;
+    }
+    auto from = *first;
+    auto to = *last;
+    if (from > to) {
+        fmt::print(os_.stdout, "{}: {} > {}\n", argv[0], from, to);
+        return 2;
+    }
+    auto json = os_.getenv("FORMAT") == "json";
+    if (!json) {
+        fmt::print(os_.stdout, "{:>10} {:>12} {:>10} {:>10} {:>14} {:>12} {:>8}\n",
+            "ledger", "new nodes", "new MiB", "shared", "working nodes", "working MiB", "missing");
+    }
+    auto mebibytes = [](std::uint64_t bytes) {
+        return static_cast<double>(bytes) / ripple::megabytes(1);
+    };
+    try {
+        auto anchor = resolveLedger(os_, (argc > 3) ? argv[3] : ".");
+        analyzeRetention(os_.db(), anchor, from, to, [&](LedgerRetention const& ledger) {
+            if (json) {
+                Json::Value value{Json::objectValue};
+                value["ledger_index"] = ledger.seq;
+                value["nodes"] = std::to_string(ledger.nodes);
+                value["bytes"] = std::to_string(ledger.bytes);
+                value["shared"] = std::to_string(ledger.shared);
+                value["working_nodes"] = std::to_string(ledger.workingNodes);
+                value["working_bytes"] = std::to_string(ledger.workingBytes);
+                value["missing"] = std::to_string(ledger.missing);
+                return printJson(os_.stdout, value);
+            }
+            fmt::print(os_.stdout, "{:>10} {:>12} {:>10.2f} {:>10} {:>14} {:>12.1f} {:>8}\n",
+                ledger.seq, ledger.nodes, mebibytes(ledger.bytes), ledger.shared,
+                ledger.workingNodes, mebibytes(ledger.workingBytes), ledger.missing);
+            std::fflush(os_.stdout);
+        });
+    } catch (Exception const& ex) {
+        fmt::print(os_.stdout, "{}: {}: {}\n", argv[0], ex.path, ex.message);
+        return ex.code;
+    }
+    return 0;
+}
+
+/** Format sorted numbers as ranges, e.g. "1-3,5". */
+static std::string formatRanges(std::vector<std::uint32_t> const& numbers) {
+    std::string text;
+    for (std::size_t i = 0; i < numbers.size();) {
+        auto j = i;
+        while (j + 1 < numbers.size() && numbers[j + 1] <= numbers[j] + 1) {
+            ++j;
+        }
+        if (!text.empty()) {
+            text += ',';
+        }
+        text += (numbers[i] == numbers[j])
+            ? fmt::format("{}", numbers[i])
+            : fmt::format("{}-{}", numbers[i], numbers[j]);
+        i = j + 1;
+    }
+    return text;
+}
+
+int Shell::scan(int argc, char** argv) {
+    assert(argv[0] == "scan"sv);
+    if (argc > 2) {
+        fmt::print(os_.stdout, "{}: too many arguments\n", argv[0]);
+        return 1;
+    }
+    std::optional<unsigned int> workers;
+    if (argc > 1) {
+        workers = parseUint32(argv[1]);
+        if (!workers) {
+            fmt::print(os_.stdout, "{}: {}: numeric argument required\n", argv[0], argv[1]);
+            return 2;
+        }
+    }
+    auto& db = os_.db();
+    std::vector<StoreStats> partials(countWalkers(db, workers));
+    ScanTotals totals;
+    auto start = std::chrono::steady_clock::now();
+    try {
+        totals = scanStore(db, os_.gethostname(),
+            [&](unsigned int worker, NodePtr const& object, std::size_t stored) {
+                partials[worker].add(object, stored);
+            },
+            workers);
+    } catch (Exception const& ex) {
+        fmt::print(os_.stdout, "{}: {}: {}\n", argv[0], ex.path, ex.message);
+        return ex.code;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    StoreStats stats;
+    for (auto const& partial : partials) {
+        stats.merge(partial);
+    }
+    auto mebibytes = [](std::uint64_t bytes) {
+        return static_cast<double>(bytes) / ripple::megabytes(1);
+    };
+    if (os_.getenv("FORMAT") == "json") {
+        Json::Value value{Json::objectValue};
+        Json::Value prefixes{Json::objectValue};
+        for (auto const& [prefix, p] : stats.prefixes) {
+            Json::Value entry{Json::objectValue};
+            entry["count"] = std::to_string(p.count);
+            entry["bytes"] = std::to_string(p.bytes);
+            entry["stored"] = std::to_string(p.stored);
+            prefixes[typeLabel(prefix)] = entry;
+        }
+        value["prefixes"] = prefixes;
+        value["ledgers"] = formatRanges(stats.ledgers);
+        value["records"] = std::to_string(totals.records);
+        value["spills"] = std::to_string(totals.spills);
+        value["corrupt"] = std::to_string(totals.corrupt);
+        value["file_bytes"] = std::to_string(totals.bytes);
+        value["seconds"] = elapsed.count();
+        printJson(os_.stdout, value);
+        return 0;
+    }
+    fmt::print(os_.stdout, "{:<24} {:>12} {:>12} {:>12}\n", "prefix", "count", "MiB", "stored MiB");
+    for (auto const& [prefix, p] : stats.prefixes) {
+        fmt::print(os_.stdout, "{:<24} {:>12} {:>12.1f} {:>12.1f}\n",
+            typeLabel(prefix), p.count, mebibytes(p.bytes), mebibytes(p.stored));
+    }
+    fmt::print(os_.stdout, "\nledgers: {}\n", formatRanges(stats.ledgers));
+    fmt::print(os_.stdout, "# {} records ({} spills, {} corrupt), {:.1f} MiB in {:.2f} s, {:.1f} MiB/s\n",
+        totals.records, totals.spills, totals.corrupt, mebibytes(totals.bytes),
+        elapsed.count(), mebibytes(totals.bytes) / elapsed.count());
+    return 0;
+}
+
+int Shell::select(int argc, char** argv) {
+    assert(argv[0] == "select"sv);
+    // The predicate is every argument before an optional `from tree`.
+    char const* tree = ".";
+    auto end = argc;
+    if (argc > 2 && argv[argc - 2] == "from"sv) {
+        tree = argv[argc - 1];
+        end = argc - 2;
+    }
+    std::string text;
+    for (auto i = 1; i < end; ++i) {
+        text += argv[i];
+        text += ' ';
+    }
+    if (text.empty()) {
+        fmt::print(os_.stdout, "{}: usage: select predicate [from tree]\n", argv[0]);
+        return 2;
+    }
+    Predicate predicate;
+    try {
+        predicate = Predicate::compile(text);
+    } catch (std::invalid_argument const& ex) {
+        fmt::print(os_.stdout, "{}: {}\n", argv[0], ex.what());
+        return 2;
+    }
+    auto json = os_.getenv("FORMAT") == "json";
+    try {
+        auto root = resolveTree(os_, tree);
+        // Only the matches are deserialized.
+        for (auto const& object : xrplorer::select(os_.db(), root, predicate)) {
+            auto sle = splitLeaf(object)->sle();
+            if (json) {
+                auto value = sle.getJson(ripple::JsonOptions::none);
+                value["index"] = to_string(sle.key());
+                printJson(os_.stdout, value);
+                continue;
+            }
+            auto line = to_string(sle.key());
+            for (auto const* field : predicate.fields) {
+                if (sle.isFieldPresent(*field)) {
+                    line += fmt::format(" {}={}",
+                        field->getName(), sle.peekAtPField(*field)->getText());
+                }
+            }
+            fmt::print(os_.stdout, "{}\n", line);
+        }
+    } catch (Exception const& ex) {
+        fmt::print(os_.stdout, "{}: {}: {}\n", argv[0], ex.path, ex.message);
+        return ex.code;
+    }
+    return 0;
+}
+
+int Shell::snapshot(int argc, char** argv) {
+    assert(argv[0] == "snapshot"sv);
+    if (argc != 3) {
+        fmt::print(os_.stdout, "{}: usage: snapshot ledger file\n", argv[0]);
+        return 2;
+    }
+    try {
+        auto header = resolveLedger(os_, argv[1]);
+        auto stats = writeSnapshot(os_.db(), header, argv[2]);
+        fmt::print(os_.stdout, "{} nodes, {:.1f} MiB\n",
+            stats.nodes, static_cast<double>(stats.bytes) / ripple::megabytes(1));
+    } catch (Exception const& ex) {
+        fmt::print(os_.stdout, "{}: {}: {}\n", argv[0], ex.path, ex.message);
+        return ex.code;
+    }
+    return 0;
+}
+
+int Shell::stat(int argc, char** argv) {
+    assert(argv[0] == "stat"sv);
+    if (argc > 2) {
+        fmt::print(os_.stdout, "{}: too many arguments\n", argv[0]);
+        return 1;
+    }
+    TreeStats stats;
+    try {
+        auto root = resolveTree(os_, (argc > 1) ? argv[1] : ".");
+        stats = statTree(os_.db(), root);
+    } catch (Exception const& ex) {
+        fmt::print(os_.stdout, "{}: {}: {}\n", argv[0], ex.path, ex.message);
+        return ex.code;
+    }
+    if (os_.getenv("FORMAT") == "json") {
+        Json::Value value{Json::objectValue};
+        Json::Value types{Json::objectValue};
+        for (auto const& [type, t] : stats.types) {
+            Json::Value entry{Json::objectValue};
+            entry["count"] = std::to_string(t.count);
+            entry["bytes"] = std::to_string(t.bytes);
+            entry["min"] = std::to_string(t.min);
+            entry["max"] = std::to_string(t.max);
+            Json::Value sizes{Json::objectValue};
+            for (auto b = 0u; b < t.sizes.size(); ++b) {
+                if (t.sizes[b]) {
+                    sizes[sizeRange(b)] = std::to_string(t.sizes[b]);
+                }
+            }
+            entry["sizes"] = sizes;
+            types[typeLabel(type)] = entry;
+        }
+        value["types"] = types;
+        Json::Value depths{Json::arrayValue};
+        for (auto d = 0u; d < stats.innersByDepth.size(); ++d) {
+            if (stats.innersByDepth[d] || stats.leavesByDepth[d]) {
+                Json::Value depth{Json::objectValue};
+                depth["depth"] = d;
+                depth["inner"] = std::to_string(stats.innersByDepth[d]);
+                depth["leaves"] = std::to_string(stats.leavesByDepth[d]);
+                depths.append(depth);
+            }
+        }
+        value["depths"] = depths;
+        Json::Value fanout{Json::arrayValue};
+        for (auto const& count : stats.fanout) {
+            fanout.append(std::to_string(count));
+        }
+        value["fanout"] = fanout;
+        value["inner_bytes"] = std::to_string(stats.innerBytes);
+        value["missing"] = std::to_string(stats.missing);
+        printJson(os_.stdout, value);
+        return 0;
+    }
+    fmt::print(os_.stdout, "{:<24} {:>12} {:>14} {:>8} {:>8} {:>8}\n",
+        "type", "count", "bytes", "mean", "min", "max");
+    for (auto const& [type, t] : stats.types) {
+        fmt::print(os_.stdout, "{:<24} {:>12} {:>14} {:>8} {:>8} {:>8}\n",
+            typeLabel(type), t.count, t.bytes, t.bytes / t.count, t.min, t.max);
+        for (auto b = 0u; b < t.sizes.size(); ++b) {
+            if (t.sizes[b]) {
+                fmt::print(os_.stdout, "    {:>20} {:>12}\n", sizeRange(b), t.sizes[b]);
+            }
+        }
+    }
+    fmt::print(os_.stdout, "\n{:>5} {:>12} {:>12}\n", "depth", "inner", "leaves");
+    for (auto d = 0u; d < stats.innersByDepth.size(); ++d) {
+        if (stats.innersByDepth[d] || stats.leavesByDepth[d]) {
+            fmt::print(os_.stdout, "{:>5} {:>12} {:>12}\n",
+                d, stats.innersByDepth[d], stats.leavesByDepth[d]);
+        }
+    }
+    fmt::print(os_.stdout, "\n{:>6} {:>12}\n", "fanout", "inner");
+    for (auto f = 1u; f < stats.fanout.size(); ++f) {
+        if (stats.fanout[f]) {
+            fmt::print(os_.stdout, "{:>6} {:>12}\n", f, stats.fanout[f]);
+        }
+    }
+    fmt::print(os_.stdout, "\ninner bytes: {}\nmissing nodes: {}\n",
+        stats.innerBytes, stats.missing);
+    return 0;
+}
+
+int Shell::trace(int argc, char** argv) {
+    assert(argv[0] == "trace"sv);
+    if (argc > 2) {
+        fmt::print(os_.stdout, "{}: too many arguments\n", argv[0]);
+        return 1;
+    }
+    std::shared_ptr<TraceWriter> trace;
+    if (argc > 1) {
+        try {
+            trace = std::make_shared<TraceWriter>(argv[1]);
+        } catch (Exception const& ex) {
+            fmt::print(os_.stdout, "{}: {}: {}\n", argv[0], ex.path, ex.message);
+            return ex.code;
+        }
+    }
+    // Fetches in flight may still hold the previous trace.
+    if (auto previous = os_.db().trace(std::move(trace))) {
+        try {
+            auto count = previous->close();
+            fmt::print(os_.stdout, "# {} fetches traced to {}\n", count, previous->path());
+        } catch (Exception const& ex) {
+            fmt::print(os_.stdout, "{}: {}: {}\n", argv[0], ex.path, ex.message);
+            return ex.code;
+        }
+    }
+    return 0;
+}
+
+int Shell::unset(int argc, char** argv) {
+    assert(argv[0] == "unset"sv);
+    for (auto i = 1; i < argc; ++i) {
+        os_.unsetenv(argv[i]);
+    }
+    return 0;
+}
+
 }
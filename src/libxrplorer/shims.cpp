@@ -0,0 +1,114 @@
+#include <xrplorer/shims.hpp>
+
+#include <fmt/core.h>
+#include <xrpl/basics/Slice.h>
+#include <xrpl/basics/safe_cast.h>
+#include <xrpl/protocol/Serializer.h>
+#include <xrpl/protocol/TxMeta.h>
+
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace ripple {
+
+std::string format_as(NodeObjectType const& type) {
+    return to_string(type);
+}
+
+std::string format_as(LedgerEntryType type) {
+    return fmt::format("0x{:04X}", std::underlying_type_t<LedgerEntryType>(type));
+}
+
+std::string format_as(HashPrefix prefix) {
+    // Prefix is 3 ASCII characters packed into a std::uint32_t.
+    std::uint32_t i = static_cast<std::underlying_type_t<HashPrefix>>(prefix);
+    char a = (i >> 24) & 0xFF;
+    char b = (i >> 16) & 0xFF;
+    char c = (i >>  8) & 0xFF;
+    return fmt::format("0x{:X} ({}{}{})", i, a, b, c);
+}
+
+HashPrefix deserializePrefix(NodePtr const& object) {
+    // TODO: Shouldn't Slice have an implicit constructor from vector of bytes?
+    auto const& slice = makeSlice(object->getData());
+    SerialIter sit{slice};
+    auto prefix = safe_cast<HashPrefix>(sit.get32());
+    return prefix;
+}
+
+LedgerHeader deserializePrefixedHeader(NodePtr const& object) {
+    auto const& slice = makeSlice(object->getData());
+    return deserializePrefixedHeader(slice);
+}
+
+unsigned int selectBranch(uint256 const& key, unsigned int depth) {
+    auto branch = static_cast<unsigned int>(*(key.begin() + (depth / 2)));
+    if (depth & 1)
+        branch &= 0xf;
+    else
+        branch >>= 4;
+    assert(branch < SHAMapInnerNode::branchFactor);
+    return branch;
+}
+
+SLE make_sle(NodePtr const& object) {
+    auto slice = makeSlice(object->getData());
+    slice.remove_prefix(4);
+    Serializer serializer{slice.data(), slice.size()};
+    uint256 key;
+    bool success = serializer.getBitString(key, serializer.size() - key.bytes);
+    assert(success);
+    serializer.chop(key.bytes);
+    auto slice2 = serializer.slice();
+    SerialIter sit{slice2};
+    return SLE{sit, key};
+}
+
+SLE make_sle(Keylet const& keylet, NodePtr const& object) {
+    // A `Slice` is passed to `SHAMapTreeNode::makeFromPrefix`
+    // which removes the 4 byte prefix.
+    auto slice = makeSlice(object->getData());
+    slice.remove_prefix(4);
+    // It passes the remaining slice to `SHAMapTreeNode::makeAccountState`
+    // which constructs a `Serializer`
+    // (which calls itself the replacement for now-deprecated `SerialIter`)
+    // and removes the 32 byte suffix.
+    // (That suffix should match the keylet key, by the way).
+    Serializer serializer{slice.data(), slice.size()};
+    serializer.chop(32);
+    // Then it constructs a _new_ `Slice` from the `Serializer`
+    // and passes it to `make_shamapitem`,
+    // which `memcpy`s the bytes into a `SHAMapItem`.
+    // I don't know where an `STObject` is ever constructed by `SHAMap`,
+    // but that final slice is the one it is expecting.
+    auto slice2 = serializer.slice();
+    // An `STLedgerEntry` cannot be constructed
+    // with a `Slice` or a `Serializer`, though. Only a `SerialIter`.
+    SerialIter sit{slice2};
+    return SLE{sit, keylet.key};
+}
+
+STObject make_txm(NodePtr const& object) {
+    auto slice = makeSlice(object->getData());
+    slice.remove_prefix(4);
+    Serializer serializer{slice.data(), slice.size()};
+    uint256 key;
+    bool success = serializer.getBitString(key, serializer.size() - key.bytes);
+    assert(success);
+    serializer.chop(key.bytes);
+    auto slice2 = serializer.slice();
+    SerialIter sit2{slice2};
+    auto lengthTx = sit2.getVLDataLength();
+    auto sliceTx = sit2.getSlice(lengthTx);
+    SerialIter sitTx{sliceTx};
+    STObject stTx{sitTx, sfTransaction};
+    auto lengthMeta = sit2.getVLDataLength();
+    auto sliceMeta = sit2.getSlice(lengthMeta);
+    SerialIter sitMeta{sliceMeta};
+    STObject stMeta{sitMeta, sfMetadata};
+    return stTx;
+}
+
+}
@@ -0,0 +1,376 @@
+#include <xrplorer/snapshot.hpp>
+#include <xrplorer/shims.hpp>
+#include <xrplorer/walk.hpp>
+
+#include <boost/endian/conversion.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <fmt/core.h>
+#include <xrpl/basics/Slice.h>
+#include <xrpl/basics/base_uint.h>
+#include <xrpl/nodestore/Backend.h>
+#include <xrpl/nodestore/Factory.h>
+#include <xrpl/nodestore/Manager.h>
+#include <xrpl/nodestore/NodeObject.h>
+#include <xrpl/protocol/HashPrefix.h>
+#include <xrpl/protocol/Serializer.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace xrplorer {
+
+namespace NodeStore = ripple::NodeStore;
+
+constexpr std::string_view MAGIC{"XRPLSNAP"};
+constexpr std::uint32_t VERSION = 1;
+constexpr std::size_t NBYTES_HEADER = 64;
+constexpr std::size_t NBYTES_RECORD_HEADER = 6;
+constexpr std::size_t NBYTES_INDEX_ENTRY = 40;
+constexpr std::size_t NBYTES_INNER = 4 + 16 * 32;
+
+enum Encoding : std::uint8_t {
+    RAW = 0,
+    SPARSE_INNER = 1,
+};
+
+template <typename T>
+static void put(std::vector<std::uint8_t>& buffer, T value) {
+    boost::endian::native_to_little_inplace(value);
+    auto bytes = reinterpret_cast<std::uint8_t const*>(&value);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+static T get(std::uint8_t const* data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return boost::endian::little_to_native(value);
+}
+
+static bool isInner(ripple::Blob const& data) {
+    if (data.size() != NBYTES_INNER) {
+        return false;
+    }
+    ripple::SerialIter sit{ripple::makeSlice(data)};
+    return sit.get32() == static_cast<std::uint32_t>(ripple::HashPrefix::innerNode);
+}
+
+/** Append the record for `object` to `buffer`. */
+static void encode(std::vector<std::uint8_t>& buffer, ripple::NodeObject const& object) {
+    auto const& data = object.getData();
+    buffer.push_back(static_cast<std::uint8_t>(object.getType()));
+    if (!isInner(data)) {
+        buffer.push_back(RAW);
+        put<std::uint32_t>(buffer, data.size());
+        buffer.insert(buffer.end(), data.begin(), data.end());
+        return;
+    }
+    buffer.push_back(SPARSE_INNER);
+    auto const* branches = data.data() + 4;
+    std::uint16_t mask = 0;
+    for (auto i = 0u; i < 16; ++i) {
+        auto const* digest = branches + 32 * i;
+        if (std::any_of(digest, digest + 32, [](auto b) { return b != 0; })) {
+            mask |= 1 << i;
+        }
+    }
+    put<std::uint32_t>(buffer, 2 + 32 * std::popcount(mask));
+    put<std::uint16_t>(buffer, mask);
+    for (auto i = 0u; i < 16; ++i) {
+        if (mask & (1 << i)) {
+            auto const* digest = branches + 32 * i;
+            buffer.insert(buffer.end(), digest, digest + 32);
+        }
+    }
+}
+
+/**
+ * Decode the record at `data`, which has `available` bytes to read,
+ * or return nothing if it does not fit in them.
+ */
+static std::shared_ptr<ripple::NodeObject> decode(
+    std::uint8_t const* data, std::uint64_t available, ripple::uint256 const& digest)
+{
+    if (available < NBYTES_RECORD_HEADER) {
+        return nullptr;
+    }
+    auto type = static_cast<ripple::NodeObjectType>(data[0]);
+    auto encoding = data[1];
+    auto size = get<std::uint32_t>(data + 2);
+    auto const* payload = data + NBYTES_RECORD_HEADER;
+    if (size > available - NBYTES_RECORD_HEADER) {
+        return nullptr;
+    }
+    ripple::Blob blob;
+    if (encoding == RAW) {
+        blob.assign(payload, payload + size);
+    } else if (encoding == SPARSE_INNER) {
+        if (size < 2 || size != 2 + 32 * std::popcount(get<std::uint16_t>(payload))) {
+            return nullptr;
+        }
+        blob.resize(NBYTES_INNER, 0);
+        std::uint32_t prefix = static_cast<std::uint32_t>(ripple::HashPrefix::innerNode);
+        boost::endian::native_to_big_inplace(prefix);
+        std::memcpy(blob.data(), &prefix, 4);
+        auto mask = get<std::uint16_t>(payload);
+        payload += 2;
+        for (auto i = 0u; i < 16; ++i) {
+            if (mask & (1 << i)) {
+                std::memcpy(blob.data() + 4 + 32 * i, payload, 32);
+                payload += 32;
+            }
+        }
+    } else {
+        return nullptr;
+    }
+    return ripple::NodeObject::createObject(type, std::move(blob), digest);
+}
+
+SnapshotStats writeSnapshot(
+    Database& db, NodePtr const& header, std::filesystem::path const& path)
+{
+    std::ofstream out{path, std::ios::binary | std::ios::trunc};
+    if (!out) {
+        throw Exception{WRITE_FAILED, path, "cannot open for writing"};
+    }
+    // Leave room for the header, which is written last,
+    // so that an incomplete file is never mistaken for a snapshot.
+    std::vector<std::uint8_t> buffer(NBYTES_HEADER, 0);
+    std::uint64_t offset = 0;
+    struct Entry {
+        ripple::uint256 digest;
+        std::uint64_t offset;
+    };
+    std::vector<Entry> index;
+
+    // Visit children in branch order, as the parallel walk does.
+    std::vector<NodePtr> stack{header};
+    while (!stack.empty()) {
+        auto object = std::move(stack.back());
+        stack.pop_back();
+        index.push_back({object->getHash(), offset + buffer.size()});
+        encode(buffer, *object);
+        auto digests = children(object);
+        for (auto it = digests.rbegin(); it != digests.rend(); ++it) {
+            auto child = db.fetch(*it);
+            if (!child) {
+                throw Exception{NODE_MISSING, fmt::format("/nodes/{}", *it), "node missing"};
+            }
+            stack.push_back(std::move(child));
+        }
+        if (buffer.size() >= (1 << 20)) {
+            out.write(reinterpret_cast<char const*>(buffer.data()), buffer.size());
+            offset += buffer.size();
+            buffer.clear();
+        }
+    }
+
+    std::sort(index.begin(), index.end(), [](auto const& a, auto const& b) {
+        return a.digest < b.digest;
+    });
+    index.erase(
+        std::unique(index.begin(), index.end(), [](auto const& a, auto const& b) {
+            return a.digest == b.digest;
+        }),
+        index.end());
+    auto indexOffset = offset + buffer.size();
+    for (auto const& entry : index) {
+        buffer.insert(buffer.end(), entry.digest.begin(), entry.digest.end());
+        put<std::uint64_t>(buffer, entry.offset);
+    }
+    out.write(reinterpret_cast<char const*>(buffer.data()), buffer.size());
+    auto bytes = offset + buffer.size();
+
+    buffer.clear();
+    buffer.insert(buffer.end(), MAGIC.begin(), MAGIC.end());
+    put<std::uint32_t>(buffer, VERSION);
+    put<std::uint32_t>(buffer, 0);
+    put<std::uint64_t>(buffer, index.size());
+    put<std::uint64_t>(buffer, indexOffset);
+    auto const& digest = header->getHash();
+    buffer.insert(buffer.end(), digest.begin(), digest.end());
+    out.seekp(0);
+    out.write(reinterpret_cast<char const*>(buffer.data()), buffer.size());
+    out.close();
+    if (!out) {
+        throw Exception{WRITE_FAILED, path, "write failed"};
+    }
+    return {index.size(), bytes};
+}
+
+bool isSnapshot(std::filesystem::path const& path) {
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(path, ec)) {
+        return false;
+    }
+    std::ifstream in{path, std::ios::binary};
+    char magic[MAGIC.size()];
+    in.read(magic, sizeof(magic));
+    return in && std::string_view{magic, sizeof(magic)} == MAGIC;
+}
+
+class SnapshotBackend : public NodeStore::Backend {
+private:
+    std::string path_;
+    boost::iostreams::mapped_file_source file_;
+    std::uint8_t const* data_ = nullptr;
+    std::uint64_t count_ = 0;
+    std::uint64_t indexOffset_ = 0;
+    std::uint8_t const* index_ = nullptr;
+
+    Exception corrupt(std::string_view message) const {
+        return Exception{NOT_A_SNAPSHOT, path_, std::string{message}};
+    }
+
+    /** Decode the record for the index entry at `entry`. */
+    std::shared_ptr<ripple::NodeObject> record(
+        std::uint8_t const* entry, ripple::uint256 const& digest) const
+    {
+        // Records lie between the header and the index.
+        auto offset = get<std::uint64_t>(entry + 32);
+        if (offset < NBYTES_HEADER || offset >= indexOffset_) {
+            throw corrupt(fmt::format("record of {} out of bounds", digest));
+        }
+        auto object = decode(data_ + offset, indexOffset_ - offset, digest);
+        if (!object) {
+            throw corrupt(fmt::format("record of {} out of bounds", digest));
+        }
+        return object;
+    }
+
+public:
+    SnapshotBackend(std::string path) : path_(std::move(path)) {}
+
+    std::string getName() override {
+        return path_;
+    }
+
+    void open(bool createIfMissing) override {
+        file_.open(path_);
+        data_ = reinterpret_cast<std::uint8_t const*>(file_.data());
+        std::uint64_t size = file_.size();
+        if (size < NBYTES_HEADER
+            || std::string_view{reinterpret_cast<char const*>(data_), MAGIC.size()} != MAGIC
+            || get<std::uint32_t>(data_ + 8) != VERSION)
+        {
+            file_.close();
+            throw corrupt("not a snapshot");
+        }
+        count_ = get<std::uint64_t>(data_ + 16);
+        indexOffset_ = get<std::uint64_t>(data_ + 24);
+        // Divide rather than multiply, which could overflow.
+        if (indexOffset_ < NBYTES_HEADER || indexOffset_ > size
+            || count_ > (size - indexOffset_) / NBYTES_INDEX_ENTRY)
+        {
+            file_.close();
+            throw corrupt("index out of bounds");
+        }
+        index_ = data_ + indexOffset_;
+    }
+
+    bool isOpen() override {
+        return file_.is_open();
+    }
+
+    void close() override {
+        file_.close();
+    }
+
+    NodeStore::Status fetch(void const* key, std::shared_ptr<ripple::NodeObject>* pObject) override {
+        auto const* digest = static_cast<std::uint8_t const*>(key);
+        // Binary search the index.
+        std::uint64_t lo = 0, hi = count_;
+        while (lo < hi) {
+            auto mid = lo + (hi - lo) / 2;
+            auto const* entry = index_ + NBYTES_INDEX_ENTRY * mid;
+            auto cmp = std::memcmp(entry, digest, 32);
+            if (cmp == 0) {
+                *pObject = record(entry, ripple::uint256::fromVoid(digest));
+                return NodeStore::ok;
+            }
+            if (cmp < 0) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        pObject->reset();
+        return NodeStore::notFound;
+    }
+
+    std::pair<std::vector<std::shared_ptr<ripple::NodeObject>>, NodeStore::Status>
+    fetchBatch(std::vector<ripple::uint256 const*> const& hashes) override {
+        std::vector<std::shared_ptr<ripple::NodeObject>> results;
+        results.reserve(hashes.size());
+        for (auto const* hash : hashes) {
+            std::shared_ptr<ripple::NodeObject> object;
+            fetch(hash->begin(), &object);
+            results.push_back(std::move(object));
+        }
+        return {std::move(results), NodeStore::ok};
+    }
+
+    void store(std::shared_ptr<ripple::NodeObject> const&) override {
+        throw std::runtime_error{"snapshots are read-only"};
+    }
+
+    void storeBatch(NodeStore::Batch const&) override {
+        throw std::runtime_error{"snapshots are read-only"};
+    }
+
+    void sync() override {}
+
+    void for_each(std::function<void(std::shared_ptr<ripple::NodeObject>)> f) override {
+        for (std::uint64_t i = 0; i < count_; ++i) {
+            auto const* entry = index_ + NBYTES_INDEX_ENTRY * i;
+            f(record(entry, ripple::uint256::fromVoid(entry)));
+        }
+    }
+
+    int getWriteLoad() override {
+        return 0;
+    }
+
+    void setDeletePath() override {}
+
+    int fdRequired() const override {
+        return 1;
+    }
+};
+
+class SnapshotFactory : public NodeStore::Factory {
+public:
+    SnapshotFactory() {
+        NodeStore::Manager::instance().insert(*this);
+    }
+
+    ~SnapshotFactory() override {
+        NodeStore::Manager::instance().erase(*this);
+    }
+
+    std::string getName() const override {
+        return SNAPSHOT_TYPE;
+    }
+
+    std::unique_ptr<NodeStore::Backend> createInstance(
+        std::size_t keyBytes,
+        ripple::Section const& section,
+        std::size_t burstSize,
+        NodeStore::Scheduler& scheduler,
+        beast::Journal journal) override
+    {
+        return std::make_unique<SnapshotBackend>(*section.get("path"));
+    }
+};
+
+static SnapshotFactory theSnapshotFactory;
+
+}
@@ -0,0 +1,96 @@
+#include <xrplorer/stat.hpp>
+#include <xrplorer/shims.hpp>
+#include <xrplorer/walk.hpp>
+
+#include <xrpl/protocol/HashPrefix.h>
+#include <xrpl/protocol/Serializer.h>
+
+#include <algorithm>
+#include <bit>
+#include <vector>
+
+namespace xrplorer {
+
+void TypeStats::add(std::uint64_t size) {
+    ++count;
+    bytes += size;
+    min = std::min(min, size);
+    max = std::max(max, size);
+    ++sizes[std::bit_width(size)];
+}
+
+void TypeStats::merge(TypeStats const& rhs) {
+    count += rhs.count;
+    bytes += rhs.bytes;
+    min = std::min(min, rhs.min);
+    max = std::max(max, rhs.max);
+    for (auto i = 0u; i < sizes.size(); ++i) {
+        sizes[i] += rhs.sizes[i];
+    }
+}
+
+void TreeStats::merge(TreeStats const& rhs) {
+    for (auto const& [type, stats] : rhs.types) {
+        types[type].merge(stats);
+    }
+    for (auto i = 0u; i < innersByDepth.size(); ++i) {
+        innersByDepth[i] += rhs.innersByDepth[i];
+        leavesByDepth[i] += rhs.leavesByDepth[i];
+    }
+    for (auto i = 0u; i < fanout.size(); ++i) {
+        fanout[i] += rhs.fanout[i];
+    }
+    innerBytes += rhs.innerBytes;
+    missing += rhs.missing;
+}
+
+TreeStats statTree(
+    Database& db,
+    ripple::uint256 const& root,
+    std::optional<unsigned int> walkers)
+{
+    std::vector<TreeStats> partials(countWalkers(db, walkers));
+    walk(db, {root}, [&](
+        unsigned int worker,
+        ripple::uint256 const& digest,
+        NodePtr const& object,
+        unsigned int depth)
+    {
+        auto& stats = partials[worker];
+        if (!object) {
+            ++stats.missing;
+            return false;
+        }
+        depth = std::min(depth, MAX_DEPTH);
+        if (auto leaf = splitLeaf(object)) {
+            ++stats.leavesByDepth[depth];
+            auto type = peekType(leaf->data);
+            auto key = type
+                ? static_cast<std::uint32_t>(*type)
+                : static_cast<std::uint32_t>(ripple::deserializePrefix(object));
+            stats.types[key].add(leaf->data.size());
+            return false;
+        }
+        if (ripple::deserializePrefix(object) != ripple::HashPrefix::innerNode) {
+            return false;
+        }
+        ripple::SerialIter sit{ripple::makeSlice(object->getData())};
+        // Consume the prefix.
+        sit.get32();
+        auto branches = 0u;
+        for (auto i = 0u; i < ripple::SHAMapInnerNode::branchFactor; ++i) {
+            branches += (sit.get256() != beast::zero);
+        }
+        ++stats.innersByDepth[depth];
+        ++stats.fanout[branches];
+        stats.innerBytes += object->getData().size();
+        return true;
+    }, walkers);
+    TreeStats total;
+    for (auto const& partial : partials) {
+        total.merge(partial);
+    }
+    return total;
+}
+
+}
@@ -0,0 +1,193 @@
+#include <xrplorer/trace.hpp>
+#include <xrplorer/context.hpp>
+
+#include <boost/endian/conversion.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <string_view>
+#include <thread>
+
+namespace xrplorer {
+
+constexpr std::string_view MAGIC{"XRPLTRCE"};
+constexpr std::uint32_t VERSION = 1;
+constexpr std::size_t NBYTES_HEADER = 16;
+constexpr std::size_t NBYTES_RECORD = 48;
+constexpr std::size_t NBYTES_BUFFER = 1 << 16;
+
+template <typename T>
+static void put(std::vector<std::uint8_t>& buffer, T value) {
+    boost::endian::native_to_little_inplace(value);
+    auto bytes = reinterpret_cast<std::uint8_t const*>(&value);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+static T get(std::uint8_t const* data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return boost::endian::little_to_native(value);
+}
+
+/** Saturate instead of wrapping for latencies over 4 seconds. */
+static std::uint32_t clamp32(std::uint64_t value) {
+    return static_cast<std::uint32_t>(
+        std::min<std::uint64_t>(value, std::numeric_limits<std::uint32_t>::max()));
+}
+
+TraceWriter::TraceWriter(std::filesystem::path path)
+    : path_(std::move(path))
+    , epoch_(std::chrono::steady_clock::now())
+    , out_(path_, std::ios::binary | std::ios::trunc)
+{
+    if (!out_) {
+        throw Exception{WRITE_FAILED, path_, "cannot open for writing"};
+    }
+    buffer_.reserve(NBYTES_BUFFER + NBYTES_RECORD);
+    buffer_.insert(buffer_.end(), MAGIC.begin(), MAGIC.end());
+    put<std::uint32_t>(buffer_, VERSION);
+    put<std::uint32_t>(buffer_, 0);
+}
+
+TraceWriter::~TraceWriter() {
+    try {
+        close();
+    } catch (Exception const&) {
+        // Only `close` can report a failed write.
+    }
+}
+
+void TraceWriter::flush() {
+    // A failed stream ignores further writes,
+    // and `close` reports the failure.
+    out_.write(reinterpret_cast<char const*>(buffer_.data()), buffer_.size());
+    buffer_.clear();
+}
+
+void TraceWriter::record(
+    ripple::uint256 const& digest,
+    std::chrono::steady_clock::time_point start,
+    std::chrono::nanoseconds latency,
+    std::size_t size)
+{
+    // A fetch that started before the trace did is recorded at its start.
+    auto offset = std::max(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(start - epoch_),
+        std::chrono::nanoseconds::zero());
+    std::lock_guard lock{mutex_};
+    buffer_.insert(buffer_.end(), digest.begin(), digest.end());
+    put<std::uint64_t>(buffer_, offset.count());
+    put<std::uint32_t>(buffer_, clamp32(latency.count()));
+    put<std::uint32_t>(buffer_, clamp32(size));
+    ++count_;
+    if (buffer_.size() >= NBYTES_BUFFER) {
+        flush();
+    }
+}
+
+std::uint64_t TraceWriter::close() {
+    std::lock_guard lock{mutex_};
+    if (out_.is_open()) {
+        flush();
+        out_.close();
+        if (!out_) {
+            throw Exception{WRITE_FAILED, path_, "write failed"};
+        }
+    }
+    return count_;
+}
+
+std::vector<TraceRecord> readTrace(std::filesystem::path const& path) {
+    std::ifstream in{path, std::ios::binary};
+    if (!in) {
+        throw Exception{DOES_NOT_EXIST, path, "cannot open for reading"};
+    }
+    std::vector<std::uint8_t> bytes{
+        std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+    if (bytes.size() < NBYTES_HEADER
+        || std::string_view{reinterpret_cast<char const*>(bytes.data()), MAGIC.size()} != MAGIC
+        || get<std::uint32_t>(bytes.data() + MAGIC.size()) != VERSION)
+    {
+        throw Exception{NOT_A_TRACE, path, "not a trace"};
+    }
+    // A trace cut short by a crash keeps its whole records.
+    auto count = (bytes.size() - NBYTES_HEADER) / NBYTES_RECORD;
+    std::vector<TraceRecord> records(count);
+    auto const* data = bytes.data() + NBYTES_HEADER;
+    for (auto& record : records) {
+        record.digest = ripple::uint256::fromVoid(data);
+        record.start = get<std::uint64_t>(data + 32);
+        record.latency = get<std::uint32_t>(data + 40);
+        record.size = get<std::uint32_t>(data + 44);
+        data += NBYTES_RECORD;
+    }
+    return records;
+}
+
+ReplayStats replayTrace(
+    Database& db, std::vector<TraceRecord> const& trace, unsigned int threads)
+{
+    ReplayStats stats;
+    stats.latencies.resize(trace.size());
+    std::atomic<std::size_t> next{0};
+    std::atomic<std::uint64_t> misses{0}, bytes{0};
+    std::exception_ptr error;
+    std::mutex mutex;
+
+    auto work = [&]() {
+        try {
+            for (auto i = next++; i < trace.size(); i = next++) {
+                auto start = std::chrono::steady_clock::now();
+                auto object = db.fetch(trace[i].digest);
+                auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start);
+                stats.latencies[i] = clamp32(latency.count());
+                if (object) {
+                    bytes.fetch_add(object->getData().size(), std::memory_order_relaxed);
+                } else {
+                    misses.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        } catch (...) {
+            std::lock_guard lock{mutex};
+            error = std::current_exception();
+            next = trace.size();
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    threads = std::max(threads, 1u);
+    pool.reserve(threads);
+    for (auto i = 0u; i < threads; ++i) {
+        pool.emplace_back(work);
+    }
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    stats.fetches = trace.size();
+    stats.misses = misses;
+    stats.bytes = bytes;
+    stats.seconds = elapsed.count();
+    std::sort(stats.latencies.begin(), stats.latencies.end());
+    return stats;
+}
+
+std::uint32_t percentile(std::vector<std::uint32_t> const& values, double q) {
+    if (values.empty()) {
+        return 0;
+    }
+    auto index = static_cast<std::size_t>(q * (values.size() - 1) + 0.5);
+    return values[std::min(index, values.size() - 1)];
+}
+
+}
@@ -0,0 +1,135 @@
+#include <xrplorer/walk.hpp>
+#include <xrplorer/shamap.hpp>
+#include <xrplorer/shims.hpp>
+
+#include <xrpl/basics/Slice.h>
+#include <xrpl/basics/safe_cast.h>
+#include <xrpl/protocol/HashPrefix.h>
+#include <xrpl/protocol/Serializer.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace xrplorer {
+
+std::vector<ripple::uint256> children(NodePtr const& object) {
+    std::vector<ripple::uint256> digests;
+    auto prefix = ripple::deserializePrefix(object);
+    if (prefix == ripple::HashPrefix::ledgerMaster) {
+        auto header = ripple::deserializePrefixedHeader(object);
+        for (auto const& digest : {header.accountHash, header.txHash}) {
+            if (digest != beast::zero) {
+                digests.push_back(digest);
+            }
+        }
+        return digests;
+    }
+    if (prefix != ripple::HashPrefix::innerNode) {
+        return digests;
+    }
+    auto const& slice = ripple::makeSlice(object->getData());
+    ripple::SerialIter sit{slice};
+    // Consume the prefix.
+    sit.get32();
+    for (auto i = 0u; i < ripple::SHAMapInnerNode::branchFactor; ++i) {
+        auto childDigest = sit.get256();
+        if (childDigest != beast::zero) {
+            digests.push_back(childDigest);
+        }
+    }
+    return digests;
+}
+
+unsigned int countWalkers(Database const& db, std::optional<unsigned int> walkers) {
+    return std::max(walkers.value_or(db.options_.walkers), 1u);
+}
+
+struct Task {
+    ripple::uint256 digest;
+    unsigned int depth;
+};
+
+unsigned int walk(
+    Database& db,
+    std::vector<ripple::uint256> const& roots,
+    NodeVisitor const& visitor,
+    std::optional<unsigned int> walkers,
+    DigestFilter const& filter)
+{
+    auto nwalkers = countWalkers(db, walkers);
+    auto limit = [&]() {
+        return walkers ? nwalkers : db.concurrency();
+    };
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    // A stack makes the walk depth-first,
+    // which keeps the set of pending tasks small.
+    std::vector<Task> stack;
+    for (auto it = roots.rbegin(); it != roots.rend(); ++it) {
+        stack.push_back({*it, 0});
+    }
+    unsigned int busy = 0;
+    std::exception_ptr error;
+
+    auto work = [&](unsigned int worker) {
+        std::unique_lock lock{mutex};
+        while (true) {
+            cv.wait(lock, [&]() {
+                return error
+                    || (stack.empty() && busy == 0)
+                    || (!stack.empty() && busy < limit());
+            });
+            if (error || (stack.empty() && busy == 0)) {
+                cv.notify_all();
+                return;
+            }
+            auto task = stack.back();
+            stack.pop_back();
+            ++busy;
+            lock.unlock();
+
+            std::vector<ripple::uint256> digests;
+            try {
+                if (!filter || filter(task.digest)) {
+                    auto object = db.fetch(task.digest);
+                    if (visitor(worker, task.digest, object, task.depth) && object) {
+                        digests = children(object);
+                    }
+                }
+            } catch (...) {
+                lock.lock();
+                error = std::current_exception();
+                --busy;
+                cv.notify_all();
+                return;
+            }
+
+            lock.lock();
+            --busy;
+            // Push in reverse so that the first child is popped first.
+            for (auto it = digests.rbegin(); it != digests.rend(); ++it) {
+                stack.push_back({*it, task.depth + 1});
+            }
+            cv.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(nwalkers);
+    for (auto i = 0u; i < nwalkers; ++i) {
+        threads.emplace_back(work, i);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return nwalkers;
+}
+
+}
@@ -1,8 +1,545 @@
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include <doctest/doctest.h>
 
+#include <xrplorer/book.hpp>
+#include <xrplorer/exists.hpp>
+#include <xrplorer/extract.hpp>
+#include <xrplorer/materialize.hpp>
+#include <xrplorer/proof.hpp>
+#include <xrplorer/scan.hpp>
+#include <xrplorer/select.hpp>
+#include <xrplorer/shamap.hpp>
+#include <xrplorer/snapshot.hpp>
+#include <xrplorer/trace.hpp>
 #include <xrplorer/xrplorer.hpp>
 
+#include <fmt/core.h>
+#include <nudb/nudb.hpp>
+#include <xrpl/protocol/AccountID.h>
+#include <xrpl/protocol/HashPrefix.h>
+#include <xrpl/protocol/Indexes.h>
+#include <xrpl/protocol/STAmount.h>
+#include <xrpl/protocol/STArray.h>
+#include <xrpl/protocol/STInteger.h>
+#include <xrpl/protocol/STLedgerEntry.h>
+#include <xrpl/protocol/Serializer.h>
+
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <variant>
+
+/** A NuDB node store in a fresh temporary directory. */
+struct TempStore {
+    std::filesystem::path directory;
+    std::unique_ptr<xrplorer::Database> db;
+
+    explicit TempStore(std::string const& name)
+        : directory(std::filesystem::temp_directory_path() / name)
+    {
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+        db = std::make_unique<xrplorer::Database>(directory);
+    }
+
+    ~TempStore() {
+        db.reset();
+        std::filesystem::remove_all(directory);
+    }
+
+    ripple::uint256 store(ripple::HashPrefix prefix, ripple::Blob const& body) {
+        ripple::Serializer s;
+        s.add32(prefix);
+        s.addRaw(body);
+        auto digest = s.getSHA512Half();
+        (*db)->store(ripple::hotACCOUNT_NODE, std::move(s.modData()), digest, 0);
+        return digest;
+    }
+
+    /** Store a state leaf, and return its digest. */
+    ripple::uint256 leaf(ripple::uint256 const& key, ripple::Blob item) {
+        item.insert(item.end(), key.begin(), key.end());
+        return store(ripple::HashPrefix::leafNode, item);
+    }
+
+    /** Store an inner node, and return its digest. */
+    ripple::uint256 inner(std::array<ripple::uint256, 16> const& branches) {
+        ripple::Blob body;
+        for (auto const& digest : branches) {
+            body.insert(body.end(), digest.begin(), digest.end());
+        }
+        return store(ripple::HashPrefix::innerNode, body);
+    }
+};
+
 TEST_CASE("test case please ignore") {
     CHECK(true);
 }
+
+TEST_CASE("resolve") {
+    xrplorer::OperatingSystem os;
+    // Neither path reads the node store, which is not open.
+    auto root = xrplorer::resolve(os, "/");
+    CHECK(!root.node);
+    CHECK(std::holds_alternative<std::monostate>(root.object));
+    try {
+        xrplorer::resolve(os, "/nodes/XYZ");
+        FAIL("resolved a malformed digest");
+    } catch (xrplorer::Exception const& ex) {
+        CHECK(ex.code == xrplorer::NOT_A_DIGEST);
+    }
+}
+
+TEST_CASE("copyField") {
+    std::shared_ptr<ripple::STBase const> copy;
+    {
+        ripple::STUInt32 field{ripple::sfSequence, 7};
+        copy = xrplorer::copyField(field);
+    }
+    // The copy outlives the original.
+    CHECK(copy->getFName() == ripple::sfSequence);
+    CHECK(copy->getText() == "7");
+}
+
+TEST_CASE("decodeTransaction") {
+    // An inner node with every branch empty.
+    ripple::Serializer s;
+    s.add32(ripple::HashPrefix::innerNode);
+    s.addRaw(ripple::Blob(16 * 32, 0));
+    auto inner = ripple::NodeObject::createObject(
+        ripple::hotTRANSACTION_NODE, std::move(s.modData()), ripple::uint256{1});
+    try {
+        xrplorer::decodeTransaction(inner);
+        FAIL("decoded an inner node as a transaction");
+    } catch (xrplorer::Exception const& ex) {
+        CHECK(ex.code == xrplorer::TYPE_UNKNOWN);
+    }
+}
+
+TEST_CASE("KeyRange::parse") {
+    using xrplorer::KeyRange;
+    auto prefix = KeyRange::parse("0A3");
+    REQUIRE(prefix);
+    CHECK(to_string(prefix->first) == "0A30000000000000000000000000000000000000000000000000000000000000");
+    CHECK(to_string(prefix->last) == "0A3FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF");
+    auto range = KeyRange::parse("0A..0C");
+    REQUIRE(range);
+    CHECK(range->contains(prefix->first));
+    CHECK(!range->contains(KeyRange::parse("0D")->first));
+    CHECK(KeyRange::parse("..")->contains(KeyRange::parse("F")->last));
+    CHECK(!KeyRange::parse(""));
+    CHECK(!KeyRange::parse("XYZ"));
+    CHECK(xrplorer::intersect(*KeyRange::parse("0B"), *KeyRange::parse("0C")).empty());
+}
+
+TEST_CASE("parseIssue") {
+    using xrplorer::parseIssue;
+    using xrplorer::formatIssue;
+    auto xrp = parseIssue("XRP");
+    REQUIRE(xrp);
+    CHECK(formatIssue(*xrp) == "XRP");
+    auto usd = parseIssue("USD.rhub8VRN55s94qWKDv6jmDy1pUykJzF3wq");
+    REQUIRE(usd);
+    CHECK(formatIssue(*usd) == "USD.rhub8VRN55s94qWKDv6jmDy1pUykJzF3wq");
+    CHECK(!parseIssue("USD"));
+    CHECK(!parseIssue("XRP.rhub8VRN55s94qWKDv6jmDy1pUykJzF3wq"));
+    CHECK(!parseIssue("USD.notAnAddress"));
+}
+
+TEST_CASE("Predicate::compile") {
+    using xrplorer::Predicate;
+    auto predicate = Predicate::compile(
+        "LedgerEntryType == AccountRoot and Balance>1000000 or Balance.currency != USD");
+    REQUIRE(predicate.clauses.size() == 2);
+    CHECK(predicate.clauses[0].size() == 2);
+    CHECK(predicate.clauses[0][0].numeric);
+    CHECK(predicate.clauses[1][0].part == xrplorer::Part::CURRENCY);
+    CHECK(predicate.clauses[1][0].bytes.size() == 20);
+    CHECK(predicate.fields.size() == 2);
+    CHECK_THROWS_AS(Predicate::compile("Balance >"), std::invalid_argument);
+    CHECK_THROWS_AS(Predicate::compile("NoSuchField == 1"), std::invalid_argument);
+    CHECK_THROWS_AS(Predicate::compile("Balance ~ 1"), std::invalid_argument);
+    CHECK_THROWS_AS(Predicate::compile("Flags.currency == USD"), std::invalid_argument);
+}
+
+TEST_CASE("findField") {
+    using xrplorer::findField;
+    // LedgerEntryType, Flags, Balance (1 XRP), Account.
+    std::vector<std::uint8_t> bytes{
+        0x11, 0x00, 0x61,
+        0x22, 0x00, 0x00, 0x00, 0x00,
+        0x61, 0x40, 0x00, 0x00, 0x00, 0x00, 0x0F, 0x42, 0x40,
+        0x81, 0x14};
+    for (std::uint8_t i = 0; i < 20; ++i) {
+        bytes.push_back(i);
+    }
+    // Amendments, two hashes.
+    bytes.insert(bytes.end(), {0x03, 0x13, 0x40});
+    for (std::uint8_t i = 0; i < 64; ++i) {
+        bytes.push_back(i);
+    }
+    ripple::Slice data{bytes.data(), bytes.size()};
+    auto account = findField(data, ripple::sfAccount);
+    REQUIRE(account);
+    CHECK(account->size() == 20);
+    CHECK((*account)[19] == 19);
+    auto balance = findField(data, ripple::sfBalance);
+    REQUIRE(balance);
+    CHECK(balance->size() == 8);
+    CHECK(!findField(data, ripple::sfSequence));
+    CHECK(!findField(data, ripple::sfDestination));
+    auto hashes = findField(data, ripple::sfAmendments);
+    REQUIRE(hashes);
+    CHECK(hashes->size() == 64);
+    CHECK((*hashes)[0] == 0);
+}
+
+TEST_CASE("Predicate") {
+    using xrplorer::Leaf;
+    using xrplorer::Predicate;
+    auto serialize = [](ripple::SLE const& sle) {
+        ripple::Serializer s;
+        sle.add(s);
+        return s.peekData();
+    };
+
+    // Every field of an account root has a size in its header.
+    auto id = ripple::AccountID::fromVoid(ripple::uint256{7}.data());
+    ripple::SLE account{ripple::keylet::account(id)};
+    account.setAccountID(ripple::sfAccount, id);
+    account.setFieldAmount(ripple::sfBalance, ripple::STAmount{std::uint64_t{5000000}});
+    account.setFieldU32(ripple::sfSequence, 3);
+    auto accountBytes = serialize(account);
+    Leaf accountLeaf{account.key(), ripple::makeSlice(accountBytes)};
+    CHECK(Predicate::compile("Balance > 1000000")(accountLeaf));
+    CHECK(!Predicate::compile("Balance > 9000000")(accountLeaf));
+    CHECK(Predicate::compile(
+        fmt::format("Account == {} and Sequence == 3", ripple::toBase58(id)))(accountLeaf));
+    CHECK(!Predicate::compile("Sequence == 3 and OwnerCount > 0")(accountLeaf));
+    CHECK(Predicate::compile("OwnerCount > 0 or LedgerEntryType == AccountRoot")(accountLeaf));
+    // A condition on an absent field is false.
+    CHECK(!Predicate::compile("TickSize == 0")(accountLeaf));
+
+    // The array of majorities precedes the wanted `TickSize`,
+    // so the scan falls back to deserializing the entry.
+    ripple::SLE amendments{ripple::keylet::amendments()};
+    ripple::STObject majority{ripple::sfMajority};
+    majority.setFieldH256(ripple::sfAmendment, ripple::uint256{1});
+    majority.setFieldU32(ripple::sfCloseTime, 1);
+    ripple::STArray majorities{ripple::sfMajorities};
+    majorities.push_back(std::move(majority));
+    amendments.setFieldArray(ripple::sfMajorities, majorities);
+    auto amendmentsBytes = serialize(amendments);
+    Leaf amendmentsLeaf{amendments.key(), ripple::makeSlice(amendmentsBytes)};
+    CHECK(Predicate::compile("TickSize == 1 or LedgerEntryType == Amendments")(amendmentsLeaf));
+    CHECK(!Predicate::compile("TickSize == 1 and LedgerEntryType == Amendments")(amendmentsLeaf));
+    CHECK(!Predicate::compile("TickSize == 1 or Flags != 0")(amendmentsLeaf));
+}
+
+TEST_CASE("verify") {
+    using namespace xrplorer;
+    ripple::uint256 key;
+    REQUIRE(key.parseHex("A000000000000000000000000000000000000000000000000000000000000001"));
+    ripple::Serializer leaf;
+    leaf.add32(ripple::HashPrefix::leafNode);
+    leaf.add32(42);
+    leaf.addBitString(key);
+    auto leafDigest = leaf.getSHA512Half();
+    Proof proof{key, {ProofLevel{}}, ripple::NodeObject::createObject(
+        ripple::hotACCOUNT_NODE, ripple::Blob{leaf.peekData()}, leafDigest)};
+    proof.path[0].branches[0xA] = leafDigest;
+    ripple::Serializer inner;
+    inner.add32(ripple::HashPrefix::innerNode);
+    for (auto const& branch : proof.path[0].branches) {
+        inner.addBitString(branch);
+    }
+    auto root = inner.getSHA512Half();
+    CHECK(proof.included());
+    CHECK(verify(proof, root));
+    proof.path[0].branches[0xB] = leafDigest;
+    CHECK(!verify(proof, root));
+}
+
+TEST_CASE("TraceWriter") {
+    auto path = std::filesystem::temp_directory_path() / "xrplorer-test.trace";
+    auto start = std::chrono::steady_clock::now();
+    {
+        xrplorer::TraceWriter trace{path};
+        trace.record(ripple::uint256{1}, start, std::chrono::nanoseconds{5}, 100);
+        trace.record(ripple::uint256{2}, start, std::chrono::nanoseconds{7}, 0);
+        CHECK(trace.close() == 2);
+    }
+    auto records = xrplorer::readTrace(path);
+    REQUIRE(records.size() == 2);
+    CHECK(records[1].digest == ripple::uint256{2});
+    CHECK(records[0].latency == 5);
+    CHECK(records[0].size == 100);
+    std::filesystem::remove(path);
+
+    if (std::filesystem::exists("/dev/full")) {
+        xrplorer::TraceWriter full{"/dev/full"};
+        full.record(ripple::uint256{1}, start, std::chrono::nanoseconds{5}, 100);
+        CHECK_THROWS_AS(full.close(), xrplorer::Exception);
+    }
+}
+
+TEST_CASE("percentile") {
+    using xrplorer::percentile;
+    CHECK(percentile({}, 0.5) == 0);
+    std::vector<std::uint32_t> values{10, 20, 30, 40, 50};
+    CHECK(percentile(values, 0) == 10);
+    CHECK(percentile(values, 0.5) == 30);
+    CHECK(percentile(values, 0.99) == 50);
+    CHECK(percentile(values, 1) == 50);
+}
+
+TEST_CASE("peekTransactionIndex") {
+    using xrplorer::peekTransactionIndex;
+    std::uint8_t meta[] = {0x20, 0x1C, 0x00, 0x00, 0x01, 0x02, 0xE1};
+    CHECK(peekTransactionIndex(ripple::Slice{meta, sizeof(meta)}) == 0x0102);
+    CHECK(!peekTransactionIndex(ripple::Slice{meta, 4}));
+    meta[1] = 0x1B;
+    CHECK(!peekTransactionIndex(ripple::Slice{meta, sizeof(meta)}));
+}
+
+TEST_CASE("BloomFilter") {
+    xrplorer::BloomFilter filter{1000};
+    for (std::uint64_t i = 0; i < 1000; ++i) {
+        filter.insert(i * 7919);
+    }
+    auto negatives = 0;
+    for (std::uint64_t i = 0; i < 1000; ++i) {
+        CHECK(filter.mayContain(i * 7919));
+        negatives += !filter.mayContain(i * 7919 + 1);
+    }
+    // About 1% false positives at 10 bits per key.
+    CHECK(negatives > 950);
+}
+
+TEST_CASE("MaterializedState::visit") {
+    using xrplorer::KeyRange;
+    xrplorer::MaterializedState state;
+    for (auto prefix : {"0A", "0B", "0C", "1A"}) {
+        state.keys.push_back(KeyRange::parse(prefix)->first);
+        state.types.push_back(ripple::ltACCOUNT_ROOT);
+        state.offsets.push_back(state.blob.size());
+        state.blob.push_back(state.keys.size());
+    }
+    state.types[1] = ripple::ltOFFER;
+    state.offsets.push_back(state.blob.size());
+    CHECK(state.find(state.keys[2]) == 2);
+    CHECK(!state.find(KeyRange::parse("0D")->first));
+    CHECK(state.leaf(3).data.size() == 1);
+    std::vector<std::size_t> seen;
+    state.visit(*KeyRange::parse("0B..0F"), std::nullopt, [&](xrplorer::Leaf const& leaf) {
+        seen.push_back(leaf.data[0]);
+        return true;
+    });
+    CHECK(seen == std::vector<std::size_t>{2, 3});
+    seen.clear();
+    state.visit(KeyRange{}, ripple::ltACCOUNT_ROOT, [&](xrplorer::Leaf const& leaf) {
+        seen.push_back(leaf.data[0]);
+        return seen.size() < 2;
+    });
+    CHECK(seen == std::vector<std::size_t>{1, 3});
+}
+
+TEST_CASE("KeyIndex") {
+    namespace fs = std::filesystem;
+    auto directory = fs::temp_directory_path() / "xrplorer-test-key-index";
+    fs::remove_all(directory);
+    fs::create_directories(directory);
+    auto dat = (directory / "nudb.dat").string();
+    auto key = (directory / "nudb.key").string();
+    auto log = (directory / "nudb.log").string();
+    auto digest = [](std::uint32_t i, std::uint8_t tag) {
+        ripple::uint256 d;
+        std::memcpy(d.data(), &i, sizeof(i));
+        d.data()[31] = tag;
+        return d;
+    };
+    nudb::error_code ec;
+    nudb::create<nudb::xxhasher>(dat, key, log, 1, nudb::make_salt(), 32, 4096, 0.5f, ec);
+    REQUIRE(!ec);
+    {
+        nudb::store store;
+        store.open(dat, key, log, ec);
+        REQUIRE(!ec);
+        // Enough keys to fill many buckets and some spills.
+        for (std::uint32_t i = 0; i < 5000; ++i) {
+            auto d = digest(i, 1);
+            store.insert(d.data(), &i, sizeof(i), ec);
+            REQUIRE(!ec);
+        }
+        store.close(ec);
+        REQUIRE(!ec);
+    }
+    std::vector<ripple::uint256> queries;
+    for (std::uint32_t i = 0; i < 5000; ++i) {
+        queries.push_back(digest(i, 1));
+        queries.push_back(digest(i, 2));
+    }
+    for (auto filter : {false, true}) {
+        xrplorer::KeyIndex index{directory};
+        if (filter) {
+            index.buildFilter(2);
+        }
+        xrplorer::ExistsStats stats;
+        auto present = index.contains(queries, stats, 3);
+        REQUIRE(present.size() == queries.size());
+        auto wrong = 0;
+        for (std::size_t i = 0; i < queries.size(); ++i) {
+            wrong += present[i] != (i % 2 == 0);
+        }
+        CHECK(wrong == 0);
+        CHECK(stats.present == 5000);
+        if (filter) {
+            CHECK(stats.filtered > 4500);
+        }
+        // One query runs on the calling thread.
+        xrplorer::ExistsStats one;
+        CHECK(index.contains({queries[0]}, one) == std::vector<bool>{true});
+        CHECK(index.contains({queries[1]}, one, 8) == std::vector<bool>{false});
+    }
+    fs::remove_all(directory);
+}
+
+TEST_CASE("scanKeys") {
+    namespace fs = std::filesystem;
+    TempStore temp{"xrplorer-test-scan-db"};
+    auto directory = fs::temp_directory_path() / "xrplorer-test-scan";
+    auto create = [&](std::size_t keySize) {
+        fs::remove_all(directory);
+        fs::create_directories(directory);
+        nudb::error_code ec;
+        nudb::create<nudb::xxhasher>(
+            (directory / "nudb.dat").string(),
+            (directory / "nudb.key").string(),
+            (directory / "nudb.log").string(),
+            1, nudb::make_salt(), keySize, 4096, 0.5f, ec);
+        REQUIRE(!ec);
+    };
+    create(32);
+    {
+        nudb::error_code ec;
+        nudb::store store;
+        store.open(
+            (directory / "nudb.dat").string(),
+            (directory / "nudb.key").string(),
+            (directory / "nudb.log").string(),
+            ec);
+        REQUIRE(!ec);
+        // Values of many sizes, so records straddle the small reads.
+        std::vector<std::uint8_t> value(300, 7);
+        for (std::uint32_t i = 0; i < 200; ++i) {
+            ripple::uint256 d{i + 1};
+            store.insert(d.data(), value.data(), 1 + i, ec);
+            REQUIRE(!ec);
+        }
+        store.close(ec);
+        REQUIRE(!ec);
+    }
+    auto scan = [&](std::vector<ripple::uint256>& found) {
+        std::vector<std::vector<ripple::uint256>> digests(2);
+        auto totals = xrplorer::scanKeys(*temp.db, directory,
+            [&](unsigned int worker, ripple::uint256 const& digest, std::size_t) {
+                digests[worker].push_back(digest);
+            },
+            2, 256);
+        for (auto const& d : digests) {
+            found.insert(found.end(), d.begin(), d.end());
+        }
+        return totals;
+    };
+    std::vector<ripple::uint256> found;
+    auto totals = scan(found);
+    CHECK(found.size() == 200);
+    CHECK(totals.records - totals.spills == 200);
+    CHECK(totals.corrupt == 0);
+    CHECK(totals.bytes == fs::file_size(directory / "nudb.dat"));
+
+    // A record claiming more bytes than the file holds
+    // is counted as corrupt, and ends the scan.
+    {
+        std::ofstream dat{directory / "nudb.dat", std::ios::binary | std::ios::app};
+        std::string record(6, '\xFF');
+        record.append(64, '\0');
+        dat << record;
+    }
+    found.clear();
+    totals = scan(found);
+    CHECK(found.size() == 200);
+    CHECK(totals.corrupt == 1);
+
+    create(20);
+    CHECK_THROWS_AS(scan(found), xrplorer::Exception);
+    fs::remove_all(directory);
+}
+
+TEST_CASE("truncated snapshot") {
+    namespace fs = std::filesystem;
+    auto path = fs::temp_directory_path() / "xrplorer-test-truncated.snapshot";
+    {
+        // A header that promises an index of 1000 entries after itself,
+        // in a file that ends with the header.
+        char header[64] = "XRPLSNAP";
+        std::uint32_t version = 1;
+        std::uint64_t count = 1000, offset = sizeof(header);
+        std::memcpy(header + 8, &version, sizeof(version));
+        std::memcpy(header + 16, &count, sizeof(count));
+        std::memcpy(header + 24, &offset, sizeof(offset));
+        std::ofstream out{path, std::ios::binary | std::ios::trunc};
+        out.write(header, sizeof(header));
+    }
+    REQUIRE(xrplorer::isSnapshot(path));
+    try {
+        xrplorer::Database db{path};
+        FAIL("opened a truncated snapshot");
+    } catch (xrplorer::Exception const& ex) {
+        CHECK(ex.code == xrplorer::NOT_A_SNAPSHOT);
+    }
+    fs::remove(path);
+}
+
+TEST_CASE("visitLeaves") {
+    using namespace xrplorer;
+    TempStore store{"xrplorer-test-visit-leaves"};
+    auto& db = *store.db;
+    // LedgerEntryType AccountRoot, then Offer.
+    ripple::Blob account{0x11, 0x00, 0x61};
+    ripple::Blob offer{0x11, 0x00, 0x6F};
+    auto key0 = KeyRange::parse("0A")->first;
+    auto key1 = KeyRange::parse("1B")->first;
+    std::array<ripple::uint256, 16> branches{};
+    branches[0] = store.leaf(key0, account);
+    branches[1] = store.leaf(key1, offer);
+    // A branch whose node is not in the store.
+    branches[2] = ripple::uint256{1};
+    auto root = db.fetch(store.inner(branches));
+    REQUIRE(root);
+
+    std::vector<ripple::uint256> keys;
+    auto collect = [&](Leaf const& leaf) {
+        keys.push_back(leaf.key);
+        return true;
+    };
+    CHECK(visitLeaves(db, root, *KeyRange::parse("0..1"), std::nullopt, collect));
+    CHECK(keys == std::vector{key0, key1});
+    keys.clear();
+    visitLeaves(db, root, *KeyRange::parse("0..1"), ripple::ltOFFER, collect);
+    CHECK(keys == std::vector{key1});
+    try {
+        visitLeaves(db, root, KeyRange{}, std::nullopt, collect);
+        FAIL("walked past a missing node");
+    } catch (Exception const& ex) {
+        CHECK(ex.code == NODE_MISSING);
+    }
+
+    CHECK(findLeaf(db, root, key1));
+    CHECK(!findLeaf(db, root, KeyRange::parse("1C")->first));
+    CHECK(!findLeaf(db, root, KeyRange::parse("3")->first));
+    CHECK_THROWS_AS(findLeaf(db, root, KeyRange::parse("2")->first), Exception);
+}